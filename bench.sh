@@ -0,0 +1,63 @@
+#!/bin/sh
+#
+# bench.sh
+#
+# Runs the simulator over a fixed matrix of synthetic traces and cache
+# configurations, reporting references/second and a checksum of the
+# statistics of each run so that performance changes can be compared and
+# regressions in the counters spotted.
+#
+# usage:  bench.sh [references per trace]
+#
+
+REFS=${1:-1000000}
+SIM=./simulador
+GEN=./tracegen
+TRACES=bench_traces
+
+PATTERNS="seq stride random chase zipf mixed"
+
+# one configuration per line: a name and the simulator flags
+CONFIGS="
+dm-8k-16b-wb-wa      -us 8192 -bs 16 -a 1 -wb -wa
+dm-8k-16b-wt-nw      -us 8192 -bs 16 -a 1 -wt -nw
+2w-split-16k-32b     -is 16384 -ds 16384 -bs 32 -a 2 -wb -wa
+8w-32k-64b-wb-wa     -us 32768 -bs 64 -a 8 -wb -wa
+8w-split-32k-wt-nw   -is 32768 -ds 32768 -bs 64 -a 8 -wt -nw
+16w-1m-64b-wt-wa     -us 1048576 -bs 64 -a 16 -wt -wa
+64w-8m-64b-wb-wa     -us 8388608 -bs 64 -a 64 -wb -wa
+16w-256m-64b-wb-nw   -us 268435456 -bs 64 -a 16 -wb -nw
+"
+
+now_ns() {
+  date +%s%N
+}
+
+mkdir -p $TRACES || exit 1
+
+for p in $PATTERNS; do
+  t=$TRACES/$p-$REFS.trace
+  if [ ! -f $t ]; then
+    $GEN -n $REFS -f 4194304 $p > $t || exit 1
+  fi
+done
+
+printf "%-8s %-20s %10s %8s %12s %10s\n" \
+  pattern config refs seconds refs/sec checksum
+echo "$CONFIGS" | while read name flags; do
+  [ -z "$name" ] && continue
+  for p in $PATTERNS; do
+    t=$TRACES/$p-$REFS.trace
+    start=$(now_ns)
+    stats=$($SIM $flags $t | sed -n '/CACHE STATISTICS/,/copies back/p')
+    end=$(now_ns)
+    sum=$(echo "$stats" | cksum | cut -d' ' -f1)
+    awk -v p=$p -v n=$name -v r=$REFS -v s=$start -v e=$end -v c=$sum 'BEGIN {
+      secs = (e - s) / 1e9;
+      printf "%-8s %-20s %10d %8.3f %12.0f %10s\n", p, n, r, secs, r / secs, c
+    }'
+  done
+done | awk '
+  { print; refs += $3; secs += $4; sum = (sum * 31 + $6) % 4294967296 }
+  END { printf "total: %d refs in %.3f s, %.0f refs/sec, checksum %.0f\n",
+               refs, secs, refs / secs, sum }'
@@ -1,13 +1,26 @@
 /*
  * cache.c
+ *
+ * Built with CACHE_KERNELS naming an X-macro list of geometries (see
+ * kernels.def), each of them gets its own copy of the access kernel with
+ * the geometry and policies as constants; init_cache() picks the one
+ * matching the configuration, or the generic kernel otherwise.
  */
 
+#define _DEFAULT_SOURCE
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 #include "cache.h"
 #include "main.h"
+#include "profile.h"
+#include "filter.h"
+#include "timing.h"
 
 /* cache configuration parameters */
 static int cache_split = 0;
@@ -16,18 +29,37 @@ static int cache_isize = DEFAULT_CACHE_SIZE;
 static int cache_dsize = DEFAULT_CACHE_SIZE;
 static int cache_block_size = DEFAULT_CACHE_BLOCK_SIZE;
 static int words_per_block = DEFAULT_CACHE_BLOCK_SIZE / WORD_SIZE;
+static int cache_sector_size = 0;	/* 0 for one sector per block */
+static int words_per_sector;
+static int sectors_per_block;
+static int sector_offset;	/* number of offset bits within a sector */
 static int cache_assoc = DEFAULT_CACHE_ASSOC;
 static int cache_writeback = DEFAULT_CACHE_WRITEBACK;
 static int cache_writealloc = DEFAULT_CACHE_WRITEALLOC;
+static int cache_profile = 0;	/* top-K of the miss profiler, 0 if off */
+static int cache_filter = FALSE;	/* write the miss/writeback stream out */
+static int cache_timing = DEFAULT_CACHE_TIMING;	/* estimate cycles and AMAT */
+static int cache_victim = DEFAULT_CACHE_VICTIM;	/* victim cache lines per cache */
+static int cache_wcb = DEFAULT_CACHE_WCB;	/* write-combining buffer entries */
 
 /* cache model data structures */
-static Pcache icache;
-static Pcache dcache;
 static cache c1;
 static cache c2;
 static cache_stat cache_stat_inst;
 static cache_stat cache_stat_data;
 
+/* write-combining buffer in front of memory, MRU first */
+static unsigned wcb_blocks[MAX_CACHE_WCB];
+static unsigned long long wcb_masks[MAX_CACHE_WCB];	/* words pending per block */
+static int wcb_count;
+static wcb_stat cache_stat_wcb;
+
+/* access kernel selected by init_cache() */
+static void access_generic(unsigned addr, unsigned access_type);
+static void (*access_fn)(unsigned addr, unsigned access_type) = access_generic;
+static const char *access_kernel_name = "generic";
+static void select_kernel();
+
 /************************************************************/
 void set_cache_param(param, value) int param;
 int value;
@@ -66,6 +98,36 @@ int value;
   case CACHE_PARAM_NOWRITEALLOC:
     cache_writealloc = FALSE;
     break;
+  case CACHE_PARAM_PROFILE:
+    cache_profile = value;
+    break;
+  case CACHE_PARAM_FILTER:
+    cache_filter = value;
+    break;
+  case CACHE_PARAM_TIMING:
+    cache_timing = value;
+    break;
+  case CACHE_PARAM_SECTOR_SIZE:
+    cache_sector_size = value;
+    break;
+  case CACHE_PARAM_VICTIM:
+    if (value < 0 || value > MAX_CACHE_VICTIM)
+    {
+      printf("error set_cache_param: victim cache must have 0 to %d lines\n",
+             MAX_CACHE_VICTIM);
+      exit(-1);
+    }
+    cache_victim = value;
+    break;
+  case CACHE_PARAM_WCB:
+    if (value < 0 || value > MAX_CACHE_WCB)
+    {
+      printf("error set_cache_param: write-combining buffer must have 0 to %d entries\n",
+             MAX_CACHE_WCB);
+      exit(-1);
+    }
+    cache_wcb = value;
+    break;
   default:
     printf("error set_cache_param: bad parameter value\n");
     exit(-1);
@@ -73,6 +135,119 @@ int value;
 }
 /************************************************************/
 
+/************************************************************/
+/*
+ * maps the metadata of one cache as a single aligned region, backed by
+ * huge pages when it is large enough for them to matter.  The region is
+ * first touched here, so its pages are placed on the NUMA node of the
+ * thread that calls init_cache().
+ */
+static void alloc_region(Pcache c, size_t bytes)
+{
+  void *p = MAP_FAILED;
+  size_t len;
+
+#ifdef MAP_ANONYMOUS
+  if (bytes >= HUGE_PAGE_SIZE)
+  {
+    len = (bytes + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+#ifdef MAP_HUGETLB
+    p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    c->region_kind = REGION_HUGETLB;
+#endif
+    if (p == MAP_FAILED)
+    { /* no reserved huge pages, map 2MB-aligned and ask for THP */
+      char *raw = mmap(NULL, len + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (raw != MAP_FAILED)
+      {
+        char *aligned = (char *)(((unsigned long)raw + HUGE_PAGE_SIZE - 1) &
+                                 ~(unsigned long)(HUGE_PAGE_SIZE - 1));
+        if (aligned > raw)
+          munmap(raw, aligned - raw);
+        munmap(aligned + len, raw + HUGE_PAGE_SIZE - aligned);
+        p = aligned;
+        c->region_kind = REGION_PAGES;
+#ifdef MADV_HUGEPAGE
+        if (madvise(p, len, MADV_HUGEPAGE) == 0)
+          c->region_kind = REGION_THP;
+#endif
+      }
+    }
+  }
+  else
+  {
+    long page = sysconf(_SC_PAGESIZE);
+    len = (bytes + page - 1) & ~(size_t)(page - 1);
+    p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    c->region_kind = REGION_PAGES;
+  }
+#else
+  len = bytes;
+  p = malloc(len);
+  c->region_kind = REGION_HEAP;
+  if (p == NULL)
+    p = MAP_FAILED;
+#endif
+
+  if (p == MAP_FAILED)
+  {
+    printf("error init_cache: cannot allocate %lu bytes of metadata\n",
+           (unsigned long)bytes);
+    exit(-1);
+  }
+  memset(p, 0, bytes);
+  c->region = p;
+  c->region_size = len;
+}
+/************************************************************/
+
+/************************************************************/
+static void free_region(Pcache c)
+{
+  if (c->region == NULL)
+    return;
+#ifdef MAP_ANONYMOUS
+  munmap(c->region, c->region_size);
+#else
+  free(c->region);
+#endif
+  c->region = NULL;
+}
+/************************************************************/
+
+/************************************************************/
+static void init_one(Pcache c, int size)
+{
+  size_t n_lines;
+
+  c->size = size;
+  c->associativity = cache_assoc;
+  c->n_sets = size / (cache_assoc * cache_block_size);
+  c->index_mask_offset = (int)LOG2(cache_block_size);
+  c->index_mask = (c->n_sets - 1) << c->index_mask_offset; /* (addr & index_mask) >> index_mask_offset would show the index bits */
+  c->tag_shift = c->index_mask_offset + LOG2(c->n_sets);
+
+  /*
+   * per line, a tag and valid and dirty sector masks; a set's lines are
+   * kept MRU first, and the victim cache's lines follow each array
+   */
+  n_lines = (size_t)c->n_sets * c->associativity;
+  c->victim_entries = cache_victim;
+  alloc_region(c, (n_lines + cache_victim) * LINE_BYTES);
+  c->tags = (unsigned *)c->region;
+  c->victim_blocks = c->tags + n_lines;
+  c->valid = (unsigned char *)(c->victim_blocks + cache_victim);
+  c->victim_valid = c->valid + n_lines;
+  c->dirty = c->victim_valid + cache_victim;
+  c->victim_dirty = c->dirty + n_lines;
+  c->victim_hits = 0;
+  c->victim_writebacks = 0;
+  c->sector_misses = 0;
+}
+/************************************************************/
+
 /************************************************************/
 void init_cache()
 {
@@ -91,508 +266,509 @@ void init_cache()
   cache_stat_data.demand_fetches = 0;
   cache_stat_data.copies_back = 0;
 
-  /* Unified case, I'll use c1 as the unified one */
-  if (cache_split == 0)
+  /* sectors, one per block unless set */
+  sectors_per_block = cache_sector_size ? cache_block_size / cache_sector_size : 1;
+  if ((cache_sector_size && (cache_sector_size < 0 ||
+                             (cache_sector_size & (cache_sector_size - 1)) ||
+                             cache_block_size % cache_sector_size)) ||
+      sectors_per_block < 1 || sectors_per_block > MAX_SECTORS ||
+      (sectors_per_block & (sectors_per_block - 1)) ||
+      cache_block_size / sectors_per_block < WORD_SIZE)
   {
-    c1.size = cache_usize;
-    c1.associativity = cache_assoc;
-    c1.n_sets = cache_usize / (cache_assoc * cache_block_size);
-    c1.index_mask_offset = (int)LOG2(cache_block_size);
-    c1.index_mask = (c1.n_sets - 1) << c1.index_mask_offset; /* (addr & index_mask) >> index_mask_offset would show the index bits */
-    /* I could get the tag with (addr) >> (c1.index_mask_offset + LOG2(c1.n_sets)) which is a right shift in the address by the number of index and offset bits */
-    c1.LRU_head = (Pcache_line *)malloc(sizeof(Pcache_line) * c1.n_sets);
-    c1.LRU_tail = (Pcache_line *)malloc(sizeof(Pcache_line) * c1.n_sets);
-    c1.set_contents = (int *)malloc(sizeof(int) * c1.n_sets);
-
-    /* We also need to initialize the LRU structure to NULL's and the contents of the cache to 0*/
-    for (int i = 0; i < c1.n_sets; i++)
-    {
-      c1.LRU_head[i] = NULL;
-      c1.LRU_tail[i] = NULL;
-      c1.set_contents[i] = 0;
-    }
-    c1.contents = 0;
+    printf("error init_cache: sectors must be a power of two from %d bytes to "
+           "the block size, at most %d per block\n", WORD_SIZE, MAX_SECTORS);
+    exit(-1);
+  }
+  words_per_sector = cache_block_size / sectors_per_block / WORD_SIZE;
+  sector_offset = (int)LOG2(cache_block_size / sectors_per_block);
+
+  wcb_count = 0;
+  cache_stat_wcb = (wcb_stat){0, 0, 0, 0};
+  if (cache_wcb && cache_block_size / WORD_SIZE > 64)
+  {
+    printf("error init_cache: write-combining buffer needs blocks of at most %d bytes\n",
+           64 * WORD_SIZE);
+    exit(-1);
+  }
+
+  if (cache_split == 0)
+  { /* Unified case, I'll use c1 as the unified one */
+    init_one(&c1, cache_usize);
   }
   else
   { /* split cache, c1 for instructions using cache_isize, and c2 for data using cache_dsize*/
+    init_one(&c1, cache_isize);
+    init_one(&c2, cache_dsize);
+  }
+  select_kernel();
 
-    /* Instruction cache */
-    c1.size = cache_isize;
-    c1.associativity = cache_assoc;
-    c1.n_sets = cache_isize / (cache_assoc * cache_block_size);
-    c1.index_mask_offset = (int)LOG2(cache_block_size);
-    c1.index_mask = (c1.n_sets - 1) << c1.index_mask_offset;
-    c1.LRU_head = (Pcache_line *)malloc(sizeof(Pcache_line) * c1.n_sets);
-    c1.LRU_tail = (Pcache_line *)malloc(sizeof(Pcache_line) * c1.n_sets);
-    c1.set_contents = (int *)malloc(sizeof(int) * c1.n_sets);
-    for (int i = 0; i < c1.n_sets; i++)
-    {
-      c1.LRU_head[i] = NULL;
-      c1.LRU_tail[i] = NULL;
-      c1.set_contents[i] = 0;
-    }
-    c1.contents = 0;
-
-    /* Data cache*/
-    c2.size = cache_dsize;
-    c2.associativity = cache_assoc;
-    c2.n_sets = cache_dsize / (cache_assoc * cache_block_size);
-    c2.index_mask_offset = (int)LOG2(cache_block_size);
-    c2.index_mask = (c2.n_sets - 1) << c2.index_mask_offset;
-    c2.LRU_head = (Pcache_line *)malloc(sizeof(Pcache_line) * c2.n_sets);
-    c2.LRU_tail = (Pcache_line *)malloc(sizeof(Pcache_line) * c2.n_sets);
-    c2.set_contents = (int *)malloc(sizeof(int) * c2.n_sets);
-    for (int i = 0; i < c2.n_sets; i++)
-    {
-      c2.LRU_head[i] = NULL;
-      c2.LRU_tail[i] = NULL;
-      c2.set_contents[i] = 0;
-    }
-    c2.contents = 0;
+  if (cache_timing)
+    init_timing();
+
+  if (cache_profile)
+    profile_init(cache_profile, c1.n_sets, cache_split ? c2.n_sets : 0,
+                 c1.index_mask_offset);
+}
+/************************************************************/
+
+/************************************************************/
+/* sends the block written back from a set of c downstream as a store */
+static void filter_writeback(Pcache c, unsigned tag, unsigned index)
+{
+  filter_emit(TRACE_DATA_STORE, (tag << c->tag_shift) | (index << c->index_mask_offset));
+}
+/************************************************************/
+
+/************************************************************/
+/* issues the oldest pending block of the write-combining buffer */
+static void wcb_drain()
+{
+  int last = wcb_count - 1;
+  int words = __builtin_popcountll(wcb_masks[last]);
+
+  cache_stat_data.copies_back += words;
+  cache_stat_wcb.bursts++;
+  cache_stat_wcb.words += words;
+  if (cache_filter)
+    filter_emit(TRACE_DATA_STORE, wcb_blocks[last] << c1.index_mask_offset);
+  wcb_count--;
+}
+/************************************************************/
+
+/************************************************************/
+/*
+ * one word written through to memory.  Without a write-combining buffer
+ * it is traffic at once; with one, stores to a pending block merge into it
+ * and only the distinct words of each block count when it is issued.
+ * Only data references write through, so the traffic is always data.
+ * filtered is set when the store already went downstream as the fetch of
+ * its miss, so that it is not filtered out twice.
+ */
+static void write_word(unsigned addr, int filtered)
+{
+  unsigned block = addr >> c1.index_mask_offset;
+  unsigned long long bit = 1ULL << ((addr >> WORD_SIZE_OFFSET) & (cache_block_size / WORD_SIZE - 1));
+  int i;
+
+  if (!cache_wcb)
+  {
+    cache_stat_data.copies_back += 1;
+    if (cache_filter && !filtered)
+      filter_emit(TRACE_DATA_STORE, addr);
+    return;
   }
+
+  cache_stat_wcb.stores++;
+  for (i = 0; i < wcb_count; i++)
+    if (wcb_blocks[i] == block)
+      break;
+  if (i < wcb_count)
+  { /* merge and move to the MRU position */
+    unsigned long long mask = wcb_masks[i];
+    if (mask & bit)
+      cache_stat_wcb.merges++;
+    memmove(wcb_blocks + 1, wcb_blocks, i * sizeof(unsigned));
+    memmove(wcb_masks + 1, wcb_masks, i * sizeof(unsigned long long));
+    wcb_blocks[0] = block;
+    wcb_masks[0] = mask | bit;
+    return;
+  }
+
+  if (wcb_count == cache_wcb)
+    wcb_drain();
+  memmove(wcb_blocks + 1, wcb_blocks, wcb_count * sizeof(unsigned));
+  memmove(wcb_masks + 1, wcb_masks, wcb_count * sizeof(unsigned long long));
+  wcb_blocks[0] = block;
+  wcb_masks[0] = bit;
+  wcb_count++;
 }
 /************************************************************/
 
 /************************************************************/
-void perform_access(unsigned addr, unsigned access_type)
+/* takes block out of the victim cache of c, with its sector masks */
+static void victim_remove(Pcache c, unsigned block, unsigned char *valid, unsigned char *dirty)
 {
-  unsigned words_in_block;
+  int i, rest;
+
+  for (i = 0; i < c->victim_entries && c->victim_valid[i]; i++)
+    if (c->victim_blocks[i] == block)
+      break;
+  if (i == c->victim_entries || !c->victim_valid[i])
+    return;
+
+  *valid = c->victim_valid[i];
+  *dirty = c->victim_dirty[i];
+  rest = c->victim_entries - i - 1;
+  memmove(c->victim_blocks + i, c->victim_blocks + i + 1, rest * sizeof(unsigned));
+  memmove(c->victim_valid + i, c->victim_valid + i + 1, rest);
+  memmove(c->victim_dirty + i, c->victim_dirty + i + 1, rest);
+  c->victim_valid[c->victim_entries - 1] = 0;
+  c->victim_dirty[c->victim_entries - 1] = 0;
+}
+/************************************************************/
 
-  if (cache_split == 0)
-  { /* Unified cache case */
-    words_in_block = (c1.size > 0) ? (cache_block_size / WORD_SIZE) : 0;
+/************************************************************/
+/* puts a line evicted from c into its victim cache, MRU first */
+static void victim_insert(Pcache c, Pcache_stat wstat, unsigned block,
+                          unsigned char valid, unsigned char dirty)
+{
+  int last = c->victim_entries - 1;
+
+  if (c->victim_dirty[last] && cache_writeback)
+  { /* the victim cache's own LRU victim goes to memory */
+    wstat->copies_back += __builtin_popcount(c->victim_dirty[last]) * words_per_sector;
+    c->victim_writebacks++;
+    if (cache_filter)
+      filter_emit(TRACE_DATA_STORE, c->victim_blocks[last] << c->index_mask_offset);
+  }
+  memmove(c->victim_blocks + 1, c->victim_blocks, last * sizeof(unsigned));
+  memmove(c->victim_valid + 1, c->victim_valid, last);
+  memmove(c->victim_dirty + 1, c->victim_dirty, last);
+  c->victim_blocks[0] = block;
+  c->victim_valid[0] = valid;
+  c->victim_dirty[0] = dirty;
+}
+/************************************************************/
 
-    /* Register the access */
-    if (access_type == TRACE_INST_LOAD)
-      cache_stat_inst.accesses++;
-    else
-      cache_stat_data.accesses++;
-
-    /* getting the tag, index, and offset */
-    unsigned tag = addr >> (c1.index_mask_offset + LOG2(c1.n_sets));
-    unsigned index = (addr & c1.index_mask) >> c1.index_mask_offset;
-    unsigned offset = addr & (cache_block_size - 1);
-
-    if (c1.associativity == 1)
-    { /* Direct-mapped unified cache case*/
-      Pcache_line line = c1.LRU_head[index];
-      if (line != NULL && line->tag == tag)
-      { /* cache hit case */
-        if (access_type == TRACE_DATA_STORE)
-        {
-          if (cache_writeback)
-            line->dirty = 1;
-          else
-            cache_stat_data.copies_back += 1;
-        }
-        delete (&c1.LRU_head[index], &c1.LRU_tail[index], line);
-        insert(&c1.LRU_head[index], &c1.LRU_tail[index], line);
-      }
+/************************************************************/
+/* moves way of a set to the MRU position */
+static void move_to_front(unsigned *tags, unsigned char *valid, unsigned char *dirty, int way)
+{
+  unsigned tag = tags[way];
+  unsigned char v = valid[way], d = dirty[way];
+
+  memmove(tags + 1, tags, way * sizeof(unsigned));
+  memmove(valid + 1, valid, way);
+  memmove(dirty + 1, dirty, way);
+  tags[0] = tag;
+  valid[0] = v;
+  dirty[0] = d;
+}
+/************************************************************/
+
+/************************************************************/
+/*
+ * One reference through c1 (unified or instruction cache) or c2 (data
+ * cache).  The counters reproduce the original per-configuration code
+ * paths exactly, including where they differ:
+ *  - a unified cache does not allocate on a no-write-allocate data miss,
+ *    a split one does (clean);
+ *  - a write-allocate data miss under write through also writes the word
+ *    through, except in a direct-mapped unified cache.
+ * Lines are made of sectors with their own valid and dirty bits: a miss
+ * fetches only the sector referenced, and a write back moves only the
+ * dirty sectors.  A reference to a present line whose sector is not valid
+ * is a sector miss, counted as a miss that replaces nothing.
+ * With a victim cache, lines evicted from a set go there instead of to
+ * memory, and a miss that finds its block there takes it back without a
+ * demand fetch (it is still counted as a miss of the cache); a split cache
+ * does so on no-write-allocate misses too, since it allocates on them.
+ * Geometry and policies come in k, so that they fold in a kernel that
+ * passes constants.
+ */
+static inline __attribute__((always_inline))
+void access_kernel(unsigned addr, unsigned access_type, cache_kernel k)
+{
+  Pcache c;
+  Pcache_stat stat, wstat;
+  unsigned char bit, refill_valid = 0, refill_dirty = 0;
+  int assoc, way, present, data_cache;
+
+  if (access_type == TRACE_INST_LOAD)
+    stat = &cache_stat_inst;
+  else
+    stat = &cache_stat_data;
+  stat->accesses++;
+
+  data_cache = k.split && access_type != TRACE_INST_LOAD;
+  c = data_cache ? &c2 : &c1;
+  wstat = k.split ? stat : &cache_stat_data; /* where copies back count */
+  assoc = k.assoc;
+
+  /* getting the tag, index and sector */
+  unsigned tag = addr >> (data_cache ? k.d_tag_shift : k.i_tag_shift);
+  unsigned index = (addr & (data_cache ? k.d_index_mask : k.i_index_mask)) >> k.block_bits;
+  unsigned *tags = c->tags + (size_t)index * assoc;
+  unsigned char *valid = c->valid + (size_t)index * assoc;
+  unsigned char *dirty = c->dirty + (size_t)index * assoc;
+  bit = 1 << ((addr >> k.sector_bits) & (k.sectors - 1));
+
+  /* valid lines are packed at the front of the set, MRU first */
+  for (way = 0; way < assoc && valid[way]; way++)
+    if (tags[way] == tag)
+      break;
+  present = (way < assoc && valid[way]);
+
+  if (present && (valid[way] & bit))
+  { /* cache hit case */
+    if (access_type == TRACE_DATA_STORE)
+    {
+      if (k.writeback)
+        dirty[way] |= bit;
       else
-      { /*cache miss case */
-        if (access_type == TRACE_INST_LOAD)
-        {
-          cache_stat_inst.misses++;
-          cache_stat_inst.demand_fetches += words_in_block;
-        }
-        else
-        { /* data store miss */
-          if (cache_writealloc)
-          {
-            cache_stat_data.misses++;
-            cache_stat_data.demand_fetches += words_in_block;
-          }
-          else
-          {
-            cache_stat_data.misses++;
-            if (cache_writeback)
-              cache_stat_data.copies_back += words_in_block;
-            else
-              cache_stat_data.copies_back += 1;
-            return;
-          }
-        }
-        if (line != NULL)
-        {
-          if (line->dirty == 1 && cache_writeback)
-            cache_stat_data.copies_back += words_in_block;
-          if (access_type == TRACE_INST_LOAD)
-            cache_stat_inst.replacements++;
-          else
-            cache_stat_data.replacements++;
-          delete (&c1.LRU_head[index], &c1.LRU_tail[index], line);
-          free(line);
-        }
-        Pcache_line new_line = (Pcache_line)malloc(sizeof(cache_line));
-        new_line->tag = tag;
-        new_line->dirty = (access_type == TRACE_DATA_STORE) ? (cache_writeback ? 1 : 0) : 0;
-        new_line->LRU_next = NULL;
-        new_line->LRU_prev = NULL;
-        insert(&c1.LRU_head[index], &c1.LRU_tail[index], new_line);
-        c1.set_contents[index] = 1;
-      }
+        write_word(addr, FALSE);
     }
+    if (way > 0)
+      move_to_front(tags, valid, dirty, way);
+    return;
+  }
+
+  /* cache miss case, unless present way is the number of valid lines */
+  stat->misses++;
+  if (present)
+    c->sector_misses++;
+  if (access_type == TRACE_INST_LOAD || k.writealloc)
+  {
+    if (!present && k.victim)
+      victim_remove(c, addr >> k.block_bits, &refill_valid, &refill_dirty);
+    if (refill_valid & bit)
+      c->victim_hits++;
     else
-    { /* set-associative unified cachecase */
-      Pcache_line curr = c1.LRU_head[index];
-      Pcache_line hit_line = NULL;
-      while (curr != NULL)
-      {
-        if (curr->tag == tag)
-        {
-          hit_line = curr;
-          break;
-        }
-        curr = curr->LRU_next;
-      }
-      if (hit_line != NULL)
-      { /* Cache hit */
-        if (access_type == TRACE_DATA_STORE)
-        {
-          if (cache_writeback)
-            hit_line->dirty = 1;
-          else
-            cache_stat_data.copies_back += 1;
-        }
-        delete (&c1.LRU_head[index], &c1.LRU_tail[index], hit_line);
-        insert(&c1.LRU_head[index], &c1.LRU_tail[index], hit_line);
-      }
+    {
+      stat->demand_fetches += k.sector_words;
+      if (cache_filter)
+        filter_emit(access_type, addr);
+    }
+    if (access_type != TRACE_INST_LOAD && !k.writeback && (k.split || assoc > 1))
+    {
+      if (access_type == TRACE_DATA_STORE)
+        write_word(addr, !(refill_valid & bit)); /* one record, fetch and write */
       else
-      { /* cache miss case */
-        if (access_type == TRACE_INST_LOAD)
-        {
-          cache_stat_inst.misses++;
-          cache_stat_inst.demand_fetches += words_in_block;
-        }
-        else
-        {
-          if (cache_writealloc)
-          {
-            cache_stat_data.misses++;
-            cache_stat_data.demand_fetches += words_in_block;
-            if (!cache_writeback)
-              cache_stat_data.copies_back += 1;
-          }
-          else
-          {
-            cache_stat_data.misses++;
-            if (cache_writeback)
-              cache_stat_data.copies_back += words_in_block;
-            else
-              cache_stat_data.copies_back += 1;
-            return;
-          }
-        }
-        if (c1.set_contents[index] >= c1.associativity)
-        {
-          /* LRU eviction from tail */
-          Pcache_line victim = c1.LRU_tail[index];
-          if (victim != NULL)
-          {
-            if (victim->dirty == 1 && cache_writeback)
-              cache_stat_data.copies_back += words_in_block;
-            if (access_type == TRACE_INST_LOAD)
-              cache_stat_inst.replacements++;
-            else
-              cache_stat_data.replacements++;
-            delete (&c1.LRU_head[index], &c1.LRU_tail[index], victim);
-            free(victim);
-          }
-        }
-        else
-        {
-          c1.set_contents[index]++;
-        }
-        Pcache_line new_line = (Pcache_line)malloc(sizeof(cache_line));
-        new_line->tag = tag;
-        new_line->dirty = (access_type == TRACE_DATA_STORE) ? (cache_writeback ? 1 : 0) : 0;
-        new_line->LRU_next = NULL;
-        new_line->LRU_prev = NULL;
-        insert(&c1.LRU_head[index], &c1.LRU_tail[index], new_line);
-      }
+        wstat->copies_back += 1;
     }
   }
-  
-  else // splitt caches case
+  else
   {
-    cache *target;
-    cache_stat *target_stat;
-    unsigned local_block_size = cache_block_size;
-    // write policies
-    int wb_local = cache_writeback;
-    int wa_local = cache_writealloc;
-
-    if (access_type == TRACE_INST_LOAD)
+    /*
+     * a split cache still allocates the block, so take it back first; a
+     * unified one does not, so a store drops the copy that would go stale
+     * and writes it back first if dirty
+     */
+    if (!present && k.victim && (k.split || access_type == TRACE_DATA_STORE))
+      victim_remove(c, addr >> k.block_bits, &refill_valid, &refill_dirty);
+    if (!k.split)
     {
-      target = &c1; // c1 for instruction cache
-      target_stat = &cache_stat_inst;
+      if (refill_dirty && k.writeback)
+      {
+        wstat->copies_back += __builtin_popcount(refill_dirty) * k.sector_words;
+        c->victim_writebacks++;
+        if (cache_filter)
+          filter_emit(TRACE_DATA_STORE, (addr >> k.block_bits) << k.block_bits);
+      }
+      refill_valid = refill_dirty = 0;
     }
-    else
+    if (refill_valid & bit)
+      c->victim_hits++;
+    if (access_type == TRACE_DATA_STORE && !k.writeback)
+      write_word(addr, FALSE);
+    else if (access_type == TRACE_DATA_STORE || !(refill_valid & bit))
     {
-      target = &c2; // c2 for the data cache
-      target_stat = &cache_stat_data;
+      wstat->copies_back += k.writeback ? k.sector_words : 1;
+      if (cache_filter)
+        filter_emit(access_type, addr);
     }
-    target_stat->accesses++;
-
-    unsigned tag = addr >> (target->index_mask_offset + LOG2(target->n_sets));
-    unsigned index = (addr & target->index_mask) >> target->index_mask_offset;
-    unsigned local_words_in_block = local_block_size / WORD_SIZE;
+    if (!k.split)
+      return;
+  }
 
-    if (target->associativity == 1)
-    { /* Direct-mapped split cache */
-      Pcache_line line = target->LRU_head[index];
-      if (line != NULL && line->tag == tag)
-      {
-        if (access_type == TRACE_DATA_STORE)
-        {
-          if (wb_local)
-            line->dirty = 1;
-          else
-            target_stat->copies_back += 1;
-        }
-        delete (&target->LRU_head[index], &target->LRU_tail[index], line);
-        insert(&target->LRU_head[index], &target->LRU_tail[index], line);
-      }
-      else
-      {
-        if (access_type == TRACE_INST_LOAD)
-        {
-          target_stat->misses++;
-          target_stat->demand_fetches += local_words_in_block;
-        }
-        else
-        {
-          if (wa_local)
-          {
-            target_stat->misses++;
-            target_stat->demand_fetches += local_words_in_block;
-            if (!wb_local)
-              target_stat->copies_back += 1;
-          }
-          else
-          {
-            target_stat->misses++;
-            if (wb_local)
-              target_stat->copies_back += local_words_in_block;
-            else
-              target_stat->copies_back += 1;
-            ;
-          }
-        }
-        if (line != NULL)
-        {
-          if (line->dirty && wb_local)
-            target_stat->copies_back += local_words_in_block;
-          if (access_type == TRACE_INST_LOAD)
-            target_stat->replacements++;
-          else
-            target_stat->replacements++;
-          delete (&target->LRU_head[index], &target->LRU_tail[index], line);
-          free(line);
-        }
-        {
-          Pcache_line new_line = (Pcache_line)malloc(sizeof(cache_line));
-          new_line->tag = tag;
-          new_line->dirty = (access_type == TRACE_DATA_STORE) ? (wa_local ? (wb_local ? 1 : 0) : 0) : 0;
-          new_line->LRU_next = NULL;
-          new_line->LRU_prev = NULL;
-          insert(&target->LRU_head[index], &target->LRU_tail[index], new_line);
-          target->set_contents[index] = 1;
-        }
-      }
-    }
-    else
-    { /* set-associative split cache */
-      Pcache_line curr = target->LRU_head[index];
-      Pcache_line hit_line = NULL;
-      while (curr != NULL)
+  if (present)
+  { /* fill the sector in the line already there */
+    valid[way] |= bit;
+    if (way > 0)
+      move_to_front(tags, valid, dirty, way);
+  }
+  else
+  {
+    if (way == assoc)
+    { /* LRU eviction from the tail */
+      way = assoc - 1;
+      if (k.victim)
+        victim_insert(c, wstat, (tags[way] << ((data_cache ? k.d_tag_shift : k.i_tag_shift) - k.block_bits)) | index,
+                      valid[way], dirty[way]);
+      else if (dirty[way] && k.writeback)
       {
-        if (curr->tag == tag)
-        {
-          hit_line = curr;
-          break;
-        }
-        curr = curr->LRU_next;
-      }
-      if (hit_line != NULL)
-      { /* cache hitcase */
-        if (access_type == TRACE_DATA_STORE)
-        {
-          if (wb_local)
-            hit_line->dirty = 1;
-          else
-            target_stat->copies_back += 1;
-        }
-        delete (&target->LRU_head[index], &target->LRU_tail[index], hit_line);
-        insert(&target->LRU_head[index], &target->LRU_tail[index], hit_line);
-      }
-      else
-      { /* cache miss case */
-        if (access_type == TRACE_INST_LOAD)
-        {
-          target_stat->misses++;
-          target_stat->demand_fetches += local_words_in_block;
-        }
-        else
-        {
-          if (wa_local)
-          {
-            target_stat->misses++;
-            target_stat->demand_fetches += local_words_in_block;
-            if (!wb_local)
-              target_stat->copies_back += 1;
-          }
-          else
-          {
-            target_stat->misses++;
-            if (wb_local)
-              target_stat->copies_back += local_words_in_block;
-            else
-              target_stat->copies_back += 1;
-          }
-        }
-        if (target->set_contents[index] >= target->associativity)
-        {
-          Pcache_line victim = target->LRU_tail[index]; 
-          if (victim != NULL)
-          {
-            if (victim->dirty && wb_local)
-              target_stat->copies_back += local_words_in_block;
-            target_stat->replacements++;
-            delete (&target->LRU_head[index], &target->LRU_tail[index], victim);
-            free(victim);
-          }
-        }
-        else
-        {
-          target->set_contents[index]++;
-        }
-        {
-          Pcache_line new_line = (Pcache_line)malloc(sizeof(cache_line));
-          new_line->tag = tag;
-          new_line->dirty = (access_type == TRACE_DATA_STORE) ? (wa_local ? (wb_local ? 1 : 0) : 0) : 0;
-          new_line->LRU_next = NULL;
-          new_line->LRU_prev = NULL;
-          insert(&target->LRU_head[index], &target->LRU_tail[index], new_line);
-        }
+        wstat->copies_back += __builtin_popcount(dirty[way]) * k.sector_words;
+        if (cache_filter)
+          filter_writeback(c, tags[way], index);
       }
+      stat->replacements++;
     }
+    memmove(tags + 1, tags, way * sizeof(unsigned));
+    memmove(valid + 1, valid, way);
+    memmove(dirty + 1, dirty, way);
+    tags[0] = tag;
+    valid[0] = refill_valid | bit;
+    dirty[0] = refill_dirty;
   }
+  if (access_type == TRACE_DATA_STORE && k.writeback && k.writealloc)
+    dirty[0] |= bit;
 }
-
 /************************************************************/
 
 /************************************************************/
-void flush()
+/* the kernel for any configuration */
+static void access_generic(unsigned addr, unsigned access_type)
 {
-  unsigned words_in_block = c1.size > 0 ? (unsigned)(cache_block_size / WORD_SIZE) : 0;
+  access_kernel(addr, access_type, (cache_kernel){
+      cache_split, cache_assoc, c1.index_mask_offset,
+      c1.index_mask, c2.index_mask, c1.tag_shift, c2.tag_shift,
+      cache_writeback, cache_writealloc, cache_victim,
+      sector_offset, sectors_per_block, words_per_sector});
+}
+/************************************************************/
 
-  /* flush the cache */
-  if (cache_split == 0)
-  { /* for unified case flush remaining dirty bits and record statistic of copies back, also clean cache*/
-    for (int i = 0; i < c1.n_sets; i++)
-    {
-      Pcache_line current = c1.LRU_head[i];
-      while (current != NULL)
-      {
-        if (cache_writeback && current->dirty == 1)
-        {
-          cache_stat_data.copies_back += words_in_block;
-        }
-        Pcache_line temp = current;
-        current = current->LRU_next;
-        free(temp);
-      }
-      c1.LRU_head[i] = NULL;
-      c1.LRU_tail[i] = NULL;
-      c1.set_contents[i] = 0;
-    }
+#ifdef CACHE_KERNELS
+/************************************************************/
+/*
+ * the kernels for the geometries listed in CACHE_KERNELS, without victim
+ * cache and with one sector per block; every field is a constant
+ */
+#define KERNEL_BITS(x) __builtin_ctz(x)
+#define KERNEL_SETS(size, bs, assoc) ((size) / ((assoc) * (bs)))
+#define KERNEL_DSIZE(isize, dsize) ((dsize) ? (dsize) : (isize))
+#define KERNEL_POW2(x) ((x) > 0 && !((x) & ((x) - 1)))
+#define KERNEL(name, split, isize, dsize, bs, assoc, wb, wa)                  \
+  static void access_##name(unsigned addr, unsigned access_type)               \
+  {                                                                            \
+    _Static_assert((bs) >= WORD_SIZE && KERNEL_POW2(bs) &&                     \
+                   KERNEL_POW2(KERNEL_SETS(isize, bs, assoc)) &&               \
+                   KERNEL_POW2(KERNEL_SETS(KERNEL_DSIZE(isize, dsize), bs, assoc)), \
+                   "kernel " #name ": blocks and sets must be powers of two"); \
+    access_kernel(addr, access_type, (cache_kernel){                           \
+        split, assoc, KERNEL_BITS(bs),                                         \
+        (KERNEL_SETS(isize, bs, assoc) - 1) << KERNEL_BITS(bs),                \
+        (KERNEL_SETS(KERNEL_DSIZE(isize, dsize), bs, assoc) - 1) << KERNEL_BITS(bs), \
+        KERNEL_BITS(bs) + KERNEL_BITS(KERNEL_SETS(isize, bs, assoc)),          \
+        KERNEL_BITS(bs) + KERNEL_BITS(KERNEL_SETS(KERNEL_DSIZE(isize, dsize), bs, assoc)), \
+        wb, wa, 0, KERNEL_BITS(bs), 1, (bs) / WORD_SIZE});                     \
   }
-  else
-  { /* split mode */
-    for (int i = 0; i < c1.n_sets; i++)
-    {
-      Pcache_line current = c1.LRU_head[i];
-      while (current != NULL)
-      {
-        if (cache_writeback && current->dirty == 1)
-        {
-          cache_stat_inst.copies_back += words_in_block;
-        }
-        Pcache_line temp = current;
-        current = current->LRU_next;
-        free(temp);
-      }
-      c1.LRU_head[i] = NULL;
-      c1.LRU_tail[i] = NULL;
-      c1.set_contents[i] = 0;
-    }
+#include CACHE_KERNELS
+#undef KERNEL
+
+static const cache_kernel_entry kernels[] = {
+#define KERNEL(name, split, isize, dsize, bs, assoc, wb, wa) \
+  {#name, split, isize, dsize, bs, assoc, wb, wa, access_##name},
+#include CACHE_KERNELS
+#undef KERNEL
+  {NULL, 0, 0, 0, 0, 0, 0, 0, NULL}
+};
+/************************************************************/
+#endif
 
-    for (int i = 0; i < c2.n_sets; i++)
+/************************************************************/
+/* picks the kernel specialized on the configuration, if one was built */
+static void select_kernel()
+{
+  access_fn = access_generic;
+  access_kernel_name = "generic";
+#ifdef CACHE_KERNELS
+  if (cache_victim || sectors_per_block != 1)
+    return;
+  for (const cache_kernel_entry *k = kernels; k->name != NULL; k++)
+    if (k->split == cache_split && k->block_size == cache_block_size &&
+        k->assoc == cache_assoc && k->writeback == cache_writeback &&
+        k->writealloc == cache_writealloc &&
+        (cache_split ? k->isize == cache_isize && k->dsize == cache_dsize
+                     : k->isize == cache_usize))
     {
-      Pcache_line current = c2.LRU_head[i];
-      while (current != NULL)
-      {
-        if (cache_writeback && current->dirty == 1)
-        {
-          cache_stat_data.copies_back += words_in_block;
-        }
-        Pcache_line temp = current;
-        current = current->LRU_next;
-        free(temp);
-      }
-      c2.LRU_head[i] = NULL;
-      c2.LRU_tail[i] = NULL;
-      c2.set_contents[i] = 0;
+      access_fn = k->access;
+      access_kernel_name = k->name;
+      return;
     }
-  }
+#endif
 }
 /************************************************************/
 
 /************************************************************/
-void delete(head, tail, item)
-    Pcache_line *head,
-    *tail;
-Pcache_line item;
+void perform_access(unsigned addr, unsigned access_type)
 {
-  if (item->LRU_prev)
-  {
-    item->LRU_prev->LRU_next = item->LRU_next;
-  }
-  else
-  {
-    /* item at head */
-    *head = item->LRU_next;
-  }
+  Pcache_stat stat;
+  Pcache c;
+  int misses, replacements, fetches, copies_back;
 
-  if (item->LRU_next)
+  if (!cache_profile && !cache_timing)
   {
-    item->LRU_next->LRU_prev = item->LRU_prev;
+    access_fn(addr, access_type);
+    return;
   }
-  else
+
+  stat = (access_type == TRACE_INST_LOAD) ? &cache_stat_inst : &cache_stat_data;
+  c = (cache_split && access_type != TRACE_INST_LOAD) ? &c2 : &c1;
+  misses = stat->misses;
+  replacements = stat->replacements;
+  fetches = stat->demand_fetches;
+  copies_back = cache_stat_inst.copies_back + cache_stat_data.copies_back;
+  access_fn(addr, access_type);
+  copies_back = cache_stat_inst.copies_back + cache_stat_data.copies_back - copies_back;
+
+  if (cache_timing)
+    timing_access(access_type == TRACE_INST_LOAD, stat->demand_fetches - fetches,
+                  copies_back);
+
+  /* attribute the miss, if any, to the block, page and set it hit */
+  if (cache_profile && stat->misses != misses)
+    profile_miss(addr, c == &c2, (addr & c->index_mask) >> c->index_mask_offset,
+                 stat->replacements != replacements);
+}
+/************************************************************/
+
+/************************************************************/
+/* writes back the dirty lines of c into stat and invalidates it */
+static void flush_one(Pcache c, Pcache_stat stat, unsigned words_in_sector)
+{
+  size_t n_lines = (size_t)c->n_sets * c->associativity;
+
+  if (cache_writeback)
   {
-    /* item at tail */
-    *tail = item->LRU_prev;
+    for (size_t i = 0; i < n_lines; i++)
+      if (c->dirty[i])
+      {
+        stat->copies_back += __builtin_popcount(c->dirty[i]) * words_in_sector;
+        if (cache_filter)
+          filter_writeback(c, c->tags[i], i / c->associativity);
+      }
+    for (int i = 0; i < c->victim_entries; i++)
+      if (c->victim_dirty[i])
+      {
+        stat->copies_back += __builtin_popcount(c->victim_dirty[i]) * words_in_sector;
+        c->victim_writebacks++;
+        if (cache_filter)
+          filter_emit(TRACE_DATA_STORE, c->victim_blocks[i] << c->index_mask_offset);
+      }
   }
+  memset(c->valid, 0, n_lines + c->victim_entries);
+  memset(c->dirty, 0, n_lines + c->victim_entries);
 }
 /************************************************************/
 
 /************************************************************/
-/* inserts at the head of the list */
-void insert(head, tail, item)
-    Pcache_line *head,
-    *tail;
-Pcache_line item;
+void flush()
 {
-  item->LRU_next = *head;
-  item->LRU_prev = (Pcache_line)NULL;
+  unsigned words_in_sector = c1.size > 0 ? (unsigned)words_per_sector : 0;
+  int inst_copies_back = cache_stat_inst.copies_back;
+  int data_copies_back = cache_stat_data.copies_back;
 
-  if (item->LRU_next)
-    item->LRU_next->LRU_prev = item;
+  /* flush the cache */
+  if (cache_split == 0)
+  { /* for unified case flush remaining dirty bits and record statistic of copies back, also clean cache*/
+    flush_one(&c1, &cache_stat_data, words_in_sector);
+  }
   else
-    *tail = item;
+  { /* split mode */
+    flush_one(&c1, &cache_stat_inst, words_in_sector);
+    flush_one(&c2, &cache_stat_data, words_in_sector);
+  }
+
+  /* and issue whatever the write-combining buffer still holds */
+  while (wcb_count)
+    wcb_drain();
 
-  *head = item;
+  /* the flush traffic is timed too */
+  if (cache_timing)
+  {
+    timing_flush(TRUE, cache_stat_inst.copies_back - inst_copies_back);
+    timing_flush(FALSE, cache_stat_data.copies_back - data_copies_back);
+  }
 }
 /************************************************************/
 
@@ -613,16 +789,57 @@ void dump_settings()
   }
   printf("  Associativity: \t%d\n", cache_assoc);
   printf("  Block size: \t%d\n", cache_block_size);
+  if (cache_sector_size && cache_sector_size != cache_block_size)
+    printf("  Sector size: \t%d\n", cache_sector_size);
   printf("  Write policy: \t%s\n",
          cache_writeback ? "WRITE BACK" : "WRITE THROUGH");
   printf("  Allocation policy: \t%s\n",
          cache_writealloc ? "WRITE ALLOCATE" : "WRITE NO ALLOCATE");
+  if (cache_profile)
+    printf("  Miss profiler: \ttop %d\n", cache_profile);
+  if (cache_filter)
+    printf("  Miss trace filter: \ton\n");
+  if (cache_victim)
+    printf("  Victim cache: \t%d lines\n", cache_victim);
+  if (cache_wcb)
+    printf("  Write-combining buffer: \t%d entries\n", cache_wcb);
+  if (cache_timing)
+    dump_timing_settings();
 }
 /************************************************************/
 
 /************************************************************/
 void print_stats()
 {
+  static const char *region_kinds[] = {
+    "heap", "base pages", "transparent huge pages", "MAP_HUGETLB"
+  };
+  size_t n_lines = (size_t)c1.n_sets * c1.associativity + c1.victim_entries;
+  size_t mapped = c1.region_size;
+
+  if (cache_split)
+  {
+    n_lines += (size_t)c2.n_sets * c2.associativity + c2.victim_entries;
+    mapped += c2.region_size;
+  }
+  printf("\n*** CACHE METADATA ***\n");
+  printf("  lines:     %lu\n", (unsigned long)n_lines);
+  printf("  bytes:     %lu (%2.2f per line)\n",
+         (unsigned long)(n_lines * LINE_BYTES), (double)LINE_BYTES);
+  /* what a line really costs, with the page padding and huge page rounding */
+  printf("  mapped:    %lu (%2.2f per line)\n", (unsigned long)mapped,
+         n_lines ? (double)mapped / n_lines : 0.0);
+  if (cache_split)
+  {
+    printf("  I-cache:   %lu, %s\n", (unsigned long)c1.region_size,
+           region_kinds[c1.region_kind]);
+    printf("  D-cache:   %lu, %s\n", (unsigned long)c2.region_size,
+           region_kinds[c2.region_kind]);
+  }
+  else
+    printf("  backing:   %s\n", region_kinds[c1.region_kind]);
+  printf("  kernel:    %s\n", access_kernel_name);
+
   printf("\n*** CACHE STATISTICS ***\n");
 
   printf(" INSTRUCTIONS\n");
@@ -652,5 +869,120 @@ void print_stats()
                                       cache_stat_data.demand_fetches);
   printf("  copies back:   %d\n", cache_stat_inst.copies_back +
                                       cache_stat_data.copies_back);
+
+  if (cache_sector_size && cache_sector_size != cache_block_size)
+    printf(" SECTORS\n  sector misses: %d\n",
+           c1.sector_misses + (cache_split ? c2.sector_misses : 0));
+
+  if (cache_victim)
+  {
+    int hits = c1.victim_hits + (cache_split ? c2.victim_hits : 0);
+    printf(" VICTIM CACHE\n");
+    if (cache_split)
+    {
+      printf("  I-cache hits:    %d\n", c1.victim_hits);
+      printf("  D-cache hits:    %d\n", c2.victim_hits);
+    }
+    else
+      printf("  hits:      %d\n", hits);
+    printf("  writebacks: %d\n", c1.victim_writebacks + (cache_split ? c2.victim_writebacks : 0));
+    printf("  fetch words saved: %d\n", hits * words_per_sector);
+  }
+
+  if (cache_wcb)
+  {
+    printf(" WRITE-COMBINING BUFFER\n");
+    printf("  stores:    %d\n", cache_stat_wcb.stores);
+    printf("  merged:    %d\n", cache_stat_wcb.merges);
+    printf("  bursts:    %d\n", cache_stat_wcb.bursts);
+    printf("  words out: %d\n", cache_stat_wcb.words);
+    printf("  words saved: %d\n", cache_stat_wcb.stores - cache_stat_wcb.words);
+  }
+
+  if (cache_timing)
+    timing_report(cache_stat_inst.accesses, cache_stat_data.accesses);
+
+  if (cache_filter)
+    printf(" FILTERED TRACE\n  records:   %llu (%2.4f of references)\n",
+           filter_records(),
+           (double)filter_records() /
+               (cache_stat_inst.accesses + cache_stat_data.accesses
+                    ? cache_stat_inst.accesses + cache_stat_data.accesses : 1));
+
+  if (cache_profile)
+    profile_report(cache_split);
+}
+/************************************************************/
+
+/************************************************************/
+void get_cache_stats(Pcache_stat inst, Pcache_stat data)
+{
+  *inst = cache_stat_inst;
+  *data = cache_stat_data;
+}
+/************************************************************/
+
+/************************************************************/
+/* number of sets in c1 (which == 0) or c2 (which == 1), 0 if unused */
+int get_n_sets(int which)
+{
+  if (which == 0)
+    return c1.n_sets;
+  return cache_split ? c2.n_sets : 0;
+}
+/************************************************************/
+
+/************************************************************/
+/* copies the lines of a set in MRU to LRU order, returns how many */
+int get_set_lines(int which, int set, unsigned *tags, int *dirty)
+{
+  Pcache c = (which == 0) ? &c1 : &c2;
+  size_t base = (size_t)set * c->associativity;
+  int n;
+
+  for (n = 0; n < c->associativity && c->valid[base + n]; n++)
+  {
+    tags[n] = c->tags[base + n];
+    dirty[n] = c->dirty[base + n] != 0;
+  }
+  return n;
+}
+/************************************************************/
+
+/************************************************************/
+/* copies the victim cache of c1 or c2 in MRU to LRU order, returns how many */
+int get_victim_lines(int which, unsigned *blocks, int *dirty)
+{
+  Pcache c = (which == 0) ? &c1 : &c2;
+  int n;
+
+  for (n = 0; n < c->victim_entries && c->victim_valid[n]; n++)
+  {
+    blocks[n] = c->victim_blocks[n];
+    dirty[n] = c->victim_dirty[n] != 0;
+  }
+  return n;
+}
+/************************************************************/
+
+/************************************************************/
+/* name of the access kernel init_cache() selected */
+const char *get_access_kernel()
+{
+  return access_kernel_name;
+}
+/************************************************************/
+
+/************************************************************/
+/* releases the metadata regions so init_cache() can run again */
+void free_cache()
+{
+  free_region(&c1);
+  free_region(&c2);
+  memset(&c1, 0, sizeof(cache));
+  memset(&c2, 0, sizeof(cache));
+
+  if (cache_profile)
+    profile_free();
 }
 /************************************************************/
@@ -15,6 +15,11 @@
 #define DEFAULT_CACHE_ASSOC 1
 #define DEFAULT_CACHE_WRITEBACK TRUE
 #define DEFAULT_CACHE_WRITEALLOC TRUE
+#define DEFAULT_CACHE_TIMING TRUE
+#define DEFAULT_CACHE_VICTIM 0
+#define DEFAULT_CACHE_WCB 0
+#define MAX_CACHE_VICTIM 1024
+#define MAX_CACHE_WCB 64
 
 /* constants for settting cache parameters */
 #define CACHE_PARAM_BLOCK_SIZE 0
@@ -26,27 +31,47 @@
 #define CACHE_PARAM_WRITETHROUGH 6
 #define CACHE_PARAM_WRITEALLOC 7
 #define CACHE_PARAM_NOWRITEALLOC 8
+#define CACHE_PARAM_PROFILE 9
+#define CACHE_PARAM_FILTER 10
+#define CACHE_PARAM_TIMING 11
+#define CACHE_PARAM_VICTIM 12
+#define CACHE_PARAM_WCB 13
+#define CACHE_PARAM_SECTOR_SIZE 14
 
 
-/* structure definitions */
-typedef struct cache_line_ {
-  unsigned tag;
-  int dirty;
+/* metadata per line: a tag and valid and dirty sector masks */
+#define MAX_SECTORS 8
+#define LINE_BYTES (sizeof(unsigned) + 2 * sizeof(unsigned char))
+
+/* how the metadata region of a cache is backed */
+#define REGION_HEAP 0
+#define REGION_PAGES 1
+#define REGION_THP 2
+#define REGION_HUGETLB 3
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
 
-  struct cache_line_ *LRU_next;
-  struct cache_line_ *LRU_prev;
-} cache_line, *Pcache_line;
 
+/* structure definitions */
 typedef struct cache_ {
   int size;			/* cache size */
   int associativity;		/* cache associativity */
   int n_sets;			/* number of cache sets */
   unsigned index_mask;		/* mask to find cache index */
   int index_mask_offset;	/* number of zero bits in mask */
-  Pcache_line *LRU_head;	/* head of LRU list for each set */
-  Pcache_line *LRU_tail;	/* tail of LRU list for each set */
-  int *set_contents;		/* number of valid entries in set */
-  int contents;			/* number of valid entries in cache */
+  int tag_shift;		/* number of index and offset bits */
+  unsigned *tags;		/* tag of each line, sets in MRU to LRU order */
+  unsigned char *valid;		/* valid sectors of each line, 0 if invalid */
+  unsigned char *dirty;		/* dirty sectors of each line */
+  int sector_misses;		/* misses on a present line's invalid sector */
+  int victim_entries;		/* lines of the victim cache, 0 if none */
+  unsigned *victim_blocks;	/* block address of each victim, MRU first */
+  unsigned char *victim_valid;	/* valid sectors of each victim */
+  unsigned char *victim_dirty;	/* dirty sectors of each victim */
+  int victim_hits;		/* misses refilled from the victim cache */
+  int victim_writebacks;	/* dirty victims written back to memory */
+  void *region;			/* one region holding all of the above */
+  size_t region_size;		/* bytes mapped for the region */
+  int region_kind;		/* REGION_* backing of the region */
 } cache, *Pcache;
 
 typedef struct cache_stat_ {
@@ -57,16 +82,60 @@ typedef struct cache_stat_ {
   int copies_back;		/* number of write backs */
 } cache_stat, *Pcache_stat;
 
+typedef struct wcb_stat_ {
+  int stores;			/* words written through into the buffer */
+  int merges;			/* stores to a word already pending */
+  int bursts;			/* blocks issued to memory */
+  int words;			/* distinct words issued to memory */
+} wcb_stat, *Pwcb_stat;
+
+/*
+ * geometry and policies an access kernel works with; the kernels listed
+ * in CACHE_KERNELS get them as constants, the generic one from the caches
+ */
+typedef struct cache_kernel_ {
+  int split;
+  int assoc;
+  int block_bits;		/* offset bits of a block */
+  unsigned i_index_mask;	/* c1, unified or instruction cache */
+  unsigned d_index_mask;	/* c2, data cache when split */
+  int i_tag_shift;
+  int d_tag_shift;
+  int writeback;
+  int writealloc;
+  int victim;			/* victim cache lines */
+  int sector_bits;		/* offset bits of a sector */
+  int sectors;			/* sectors per block */
+  int sector_words;		/* words per sector */
+} cache_kernel;
+
+/* a specialized kernel and the configuration it is selected for */
+typedef struct cache_kernel_entry_ {
+  const char *name;
+  int split;
+  int isize;			/* unified size, or instruction cache size */
+  int dsize;			/* data cache size, 0 if unified */
+  int block_size;
+  int assoc;
+  int writeback;
+  int writealloc;
+  void (*access)(unsigned addr, unsigned access_type);
+} cache_kernel_entry;
+
 
 /* function prototypes */
 void set_cache_param();
 void init_cache();
 void perform_access();
 void flush();
-void delete();
-void insert();
 void dump_settings();
 void print_stats();
+void get_cache_stats();
+int get_n_sets();
+int get_set_lines();
+int get_victim_lines();
+const char *get_access_kernel();
+void free_cache();
 
 
 /* macros */
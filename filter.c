@@ -0,0 +1,90 @@
+/*
+ * filter.c
+ *
+ * Writes the stream of references that leave the simulated caches (misses,
+ * write-through stores and dirty writebacks) as a new trace, in the text
+ * format or in the binary one, so outer levels can be studied without
+ * replaying the full trace through the same inner cache every time.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cache.h"
+#include "main.h"
+#include "filter.h"
+
+static FILE *filter_file;
+static int filter_binary;
+static unsigned long long filter_count;
+static trace_record buffer[FILTER_BUFFER_RECORDS];
+static int buffered;
+
+/************************************************************/
+void filter_open(const char *path, int binary)
+{
+  filter_file = fopen(path, binary ? "wb" : "w");
+  if (filter_file == NULL)
+  {
+    perror("Error opening filtered trace file");
+    exit(EXIT_FAILURE);
+  }
+  filter_binary = binary;
+  filter_count = 0;
+  buffered = 0;
+  if (binary)
+    fwrite(TRACE_BINARY_MAGIC, 1, TRACE_BINARY_MAGIC_SIZE, filter_file);
+}
+/************************************************************/
+
+/************************************************************/
+static void filter_drain()
+{
+  if (buffered && fwrite(buffer, sizeof(trace_record), buffered, filter_file) != (size_t)buffered)
+  {
+    perror("Error writing filtered trace file");
+    exit(EXIT_FAILURE);
+  }
+  buffered = 0;
+}
+/************************************************************/
+
+/************************************************************/
+void filter_emit(unsigned access_type, unsigned addr)
+{
+  filter_count++;
+  if (!filter_binary)
+  {
+    fprintf(filter_file, "%u %x\n", access_type, addr);
+    return;
+  }
+  buffer[buffered].access_type = access_type;
+  buffer[buffered].addr = addr;
+  if (++buffered == FILTER_BUFFER_RECORDS)
+    filter_drain();
+}
+/************************************************************/
+
+/************************************************************/
+void filter_close()
+{
+  if (filter_file == NULL)
+    return;
+  if (filter_binary)
+    filter_drain();
+  if (fclose(filter_file) != 0)
+  {
+    perror("Error closing filtered trace file");
+    exit(EXIT_FAILURE);
+  }
+  filter_file = NULL;
+}
+/************************************************************/
+
+/************************************************************/
+unsigned long long filter_records()
+{
+  return filter_count;
+}
+/************************************************************/
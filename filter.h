@@ -0,0 +1,13 @@
+/*
+ * filter.h
+ */
+
+
+#define FILTER_BUFFER_RECORDS 4096
+
+
+/* function prototypes */
+void filter_open(const char *path, int binary);
+void filter_emit(unsigned access_type, unsigned addr);
+void filter_close();
+unsigned long long filter_records();
@@ -0,0 +1,216 @@
+/*
+ * gen.c
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "cache.h"
+#include "main.h"
+#include "gen.h"
+
+static const char *pattern_names[GEN_N_PATTERNS] = {
+  "seq", "stride", "random", "chase", "zipf", "mixed"
+};
+
+/************************************************************/
+int gen_pattern_by_name(const char *name)
+{
+  for (int i = 0; i < GEN_N_PATTERNS; i++)
+    if (!strcmp(name, pattern_names[i]))
+      return i;
+  return -1;
+}
+/************************************************************/
+
+/************************************************************/
+const char *gen_pattern_name(int pattern)
+{
+  if (pattern < 0 || pattern >= GEN_N_PATTERNS)
+    return "unknown";
+  return pattern_names[pattern];
+}
+/************************************************************/
+
+/************************************************************/
+/* xorshift64*, so that a given seed always yields the same trace */
+static unsigned long long next_rng(Pgen_state g)
+{
+  g->rng ^= g->rng >> 12;
+  g->rng ^= g->rng << 25;
+  g->rng ^= g->rng >> 27;
+  return g->rng * 0x2545F4914F6CDD1DULL;
+}
+
+/* uniform value in [0, bound) */
+unsigned gen_random(Pgen_state g, unsigned bound)
+{
+  return (unsigned)(((next_rng(g) >> 32) * (unsigned long long)bound) >> 32);
+}
+
+static double next_unit(Pgen_state g)
+{
+  return (double)(next_rng(g) >> 11) * (1.0 / 9007199254740992.0);
+}
+/************************************************************/
+
+/************************************************************/
+/* rank of a block drawn from the Zipf popularity distribution */
+static unsigned next_zipf(Pgen_state g)
+{
+  double u = next_unit(g);
+  unsigned lo = 0, hi = g->n_nodes - 1;
+
+  while (lo < hi)
+  {
+    unsigned mid = lo + (hi - lo) / 2;
+    if (g->zipf_cdf[mid] < u)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  /* scatter the ranks so the hottest blocks do not share a few sets */
+  return (unsigned)(((unsigned long long)lo * 2654435761ULL) % g->n_nodes);
+}
+/************************************************************/
+
+/************************************************************/
+void gen_init(Pgen_state g, int pattern, unsigned footprint, unsigned stride,
+              unsigned long long seed)
+{
+  memset(g, 0, sizeof(gen_state));
+  g->pattern = pattern;
+  g->footprint = footprint - footprint % GEN_NODE_SIZE;
+  if (g->footprint < GEN_NODE_SIZE)
+    g->footprint = GEN_NODE_SIZE;
+  g->stride = (stride < WORD_SIZE || stride > g->footprint) ? WORD_SIZE : stride;
+  g->n_nodes = g->footprint / GEN_NODE_SIZE;
+
+  /* splitmix64 the seed so that small seeds still give a good state */
+  seed += 0x9E3779B97F4A7C15ULL;
+  seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBULL;
+  g->rng = (seed ^ (seed >> 31)) | 1;
+
+  if (pattern == GEN_POINTER_CHASE)
+  { /* Sattolo's shuffle gives a single cycle through every node */
+    g->chain = (unsigned *)malloc(sizeof(unsigned) * g->n_nodes);
+    if (g->chain == NULL)
+    {
+      printf("error gen_init: out of memory\n");
+      exit(-1);
+    }
+    for (unsigned i = 0; i < g->n_nodes; i++)
+      g->chain[i] = i;
+    for (unsigned i = g->n_nodes - 1; i > 0; i--)
+    {
+      unsigned j = gen_random(g, i);
+      unsigned tmp = g->chain[i];
+      g->chain[i] = g->chain[j];
+      g->chain[j] = tmp;
+    }
+  }
+
+  if (pattern == GEN_ZIPF || pattern == GEN_MIXED)
+  {
+    double sum = 0.0;
+    g->zipf_cdf = (double *)malloc(sizeof(double) * g->n_nodes);
+    if (g->zipf_cdf == NULL)
+    {
+      printf("error gen_init: out of memory\n");
+      exit(-1);
+    }
+    for (unsigned i = 0; i < g->n_nodes; i++)
+    {
+      sum += 1.0 / pow((double)(i + 1), GEN_ZIPF_ALPHA);
+      g->zipf_cdf[i] = sum;
+    }
+    for (unsigned i = 0; i < g->n_nodes; i++)
+      g->zipf_cdf[i] /= sum;
+    g->zipf_cdf[g->n_nodes - 1] = 1.0;
+  }
+
+  if (pattern == GEN_MIXED)
+  {
+    g->code_size = g->footprint / 8;
+    if (g->code_size < 4096)
+      g->code_size = 4096;
+  }
+}
+/************************************************************/
+
+/************************************************************/
+void gen_next(Pgen_state g, unsigned *access_type, unsigned *addr)
+{
+  switch (g->pattern)
+  {
+  case GEN_SEQUENTIAL:
+    *addr = GEN_DATA_BASE + g->pos;
+    *access_type = ((g->pos / WORD_SIZE) % 8 == 7) ? TRACE_DATA_STORE : TRACE_DATA_LOAD;
+    g->pos += WORD_SIZE;
+    if (g->pos >= g->footprint)
+      g->pos = 0;
+    break;
+
+  case GEN_STRIDED:
+    *addr = GEN_DATA_BASE + g->pos;
+    *access_type = (gen_random(g, 4) == 0) ? TRACE_DATA_STORE : TRACE_DATA_LOAD;
+    g->pos += g->stride;
+    if (g->pos >= g->footprint) /* next column of the sweep */
+      g->pos = (g->pos - g->footprint + WORD_SIZE) % g->stride;
+    break;
+
+  case GEN_RANDOM:
+    *addr = GEN_DATA_BASE + gen_random(g, g->footprint / WORD_SIZE) * WORD_SIZE;
+    *access_type = (gen_random(g, 10) < 3) ? TRACE_DATA_STORE : TRACE_DATA_LOAD;
+    break;
+
+  case GEN_POINTER_CHASE:
+    g->pos = g->chain[g->pos];
+    *addr = GEN_DATA_BASE + g->pos * GEN_NODE_SIZE;
+    *access_type = TRACE_DATA_LOAD;
+    break;
+
+  case GEN_ZIPF:
+    *addr = GEN_DATA_BASE + next_zipf(g) * GEN_NODE_SIZE +
+            gen_random(g, GEN_NODE_SIZE / WORD_SIZE) * WORD_SIZE;
+    *access_type = (gen_random(g, 10) < 2) ? TRACE_DATA_STORE : TRACE_DATA_LOAD;
+    break;
+
+  case GEN_MIXED:
+    if (g->data_pending)
+    {
+      g->data_pending = 0;
+      *addr = GEN_DATA_BASE + next_zipf(g) * GEN_NODE_SIZE +
+              gen_random(g, GEN_NODE_SIZE / WORD_SIZE) * WORD_SIZE;
+      *access_type = (gen_random(g, 10) < 3) ? TRACE_DATA_STORE : TRACE_DATA_LOAD;
+      break;
+    }
+    *addr = GEN_CODE_BASE + g->pc;
+    *access_type = TRACE_INST_LOAD;
+    /* straight-line code with an occasional taken branch */
+    if (gen_random(g, 16) == 0)
+      g->pc = gen_random(g, g->code_size / WORD_SIZE) * WORD_SIZE;
+    else
+      g->pc = (g->pc + WORD_SIZE) % g->code_size;
+    g->data_pending = (gen_random(g, 100) < 35);
+    break;
+
+  default:
+    printf("error gen_next: bad pattern %d\n", g->pattern);
+    exit(-1);
+  }
+}
+/************************************************************/
+
+/************************************************************/
+void gen_free(Pgen_state g)
+{
+  free(g->chain);
+  free(g->zipf_cdf);
+  g->chain = NULL;
+  g->zipf_cdf = NULL;
+}
+/************************************************************/
@@ -0,0 +1,48 @@
+/*
+ * gen.h
+ */
+
+
+/* synthetic access patterns */
+#define GEN_SEQUENTIAL 0
+#define GEN_STRIDED 1
+#define GEN_RANDOM 2
+#define GEN_POINTER_CHASE 3
+#define GEN_ZIPF 4
+#define GEN_MIXED 5
+#define GEN_N_PATTERNS 6
+
+/* default generator parameters--can be changed */
+#define GEN_DEFAULT_FOOTPRINT (1024 * 1024)
+#define GEN_DEFAULT_STRIDE 256
+#define GEN_DEFAULT_SEED 1
+#define GEN_NODE_SIZE 64	/* bytes per pointer-chasing node / hot block */
+#define GEN_ZIPF_ALPHA 0.99
+#define GEN_DATA_BASE 0x10000000
+#define GEN_CODE_BASE 0x00400000
+
+
+/* structure definitions */
+typedef struct gen_state_ {
+  int pattern;			/* one of GEN_* */
+  unsigned footprint;		/* bytes touched by the data stream */
+  unsigned stride;		/* bytes between strided references */
+  unsigned long long rng;	/* xorshift64* state */
+  unsigned pos;			/* cursor for sequential/strided/chasing */
+  unsigned n_nodes;		/* blocks in the footprint */
+  unsigned *chain;		/* pointer-chasing successor of each node */
+  double *zipf_cdf;		/* cumulative popularity of each hot block */
+  unsigned pc;			/* instruction pointer for the mixed stream */
+  unsigned code_size;		/* bytes of code in the mixed stream */
+  int data_pending;		/* mixed stream owes a data reference */
+} gen_state, *Pgen_state;
+
+
+/* function prototypes */
+int gen_pattern_by_name(const char *name);
+const char *gen_pattern_name(int pattern);
+void gen_init(Pgen_state g, int pattern, unsigned footprint, unsigned stride,
+              unsigned long long seed);
+void gen_next(Pgen_state g, unsigned *access_type, unsigned *addr);
+unsigned gen_random(Pgen_state g, unsigned bound);
+void gen_free(Pgen_state g);
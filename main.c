@@ -4,13 +4,35 @@
  */
 
 
+ #define _DEFAULT_SOURCE
+
  #include <stdlib.h>
  #include <stdio.h>
+ #include <unistd.h>
+ #include <sys/types.h>
+ #include <sys/wait.h>
  #include "cache.h"
  #include "main.h"
+ #include "filter.h"
+ #include "profile.h"
+ #include "timing.h"
+ #include "tlb.h"
+ #include "trace.h"
  #include <string.h>
  
  static FILE *traceFile;
+ static int traceBinary;
+ static int useTlb;
+ static int parseThreads = -1;	/* text trace parsing threads, -1 for one per CPU */
+ static const char *traceName;
+ static int useFilter;
+ static int useIndex;
+ static int useRange;
+ static unsigned long long indexInterval;	/* 0 reuses any existing index */
+ static Ptrace_index traceIndex;
+ static unsigned long long rangeStart;	/* first record replayed */
+ static unsigned long long rangeCount;	/* records replayed, 0 for all */
+ static int traceSegments = 1;
  
  
  int main(argc, argv)
@@ -18,9 +40,21 @@
    char **argv;
  {
    parse_args(argc, argv);
+   if (traceSegments > 1) {
+     play_segments();
+     trace_free_index(traceIndex);
+     return(0);
+   }
    init_cache();
+   if (useTlb)
+     init_tlb();
    play_trace(traceFile);
+   filter_close();
    print_stats();
+   if (useTlb)
+     print_tlb_stats();
+   trace_free_index(traceIndex);
+   return(0);
  }
  
  
@@ -49,6 +83,29 @@
        printf("\t-wt: \t\tset write policy to write through\n");
        printf("\t-wa: \t\tset allocation policy to write allocate\n");
        printf("\t-nw: \t\tset allocation policy to no write allocate\n");
+       printf("\t-prof <k>: \treport the <k> hottest missing blocks, pages and sets\n");
+       printf("\t\t\t(%d if <k> is not positive)\n", PROFILE_DEFAULT_TOP_K);
+       printf("\t-ss <ss>: \tset cache sector size to <ss>\n");
+       printf("\t-vc <n>: \tadd a victim cache of <n> lines to each cache\n");
+       printf("\t-wcb <n>: \tadd a write-combining buffer of <n> entries\n");
+       printf("\t-hl <c>: \tset hit latency to <c> cycles\n");
+       printf("\t-mp <c>: \tset miss penalty to <c> cycles\n");
+       printf("\t-mbw <b>: \tset memory bandwidth to <b> bytes per cycle\n");
+       printf("\t-wbuf <n>: \tset write buffer to <n> entries\n");
+       printf("\t-notiming: \tturn off the timing model\n");
+       printf("\t-tlb: \t\tsimulate the TLBs with the default parameters\n");
+       printf("\t-pg <pg>: \tset page size to <pg> (also -tlb)\n");
+       printf("\t-itlb <n>: \tset instruction TLB entries to <n> (also -tlb)\n");
+       printf("\t-dtlb <n>: \tset data TLB entries to <n> (also -tlb)\n");
+       printf("\t-stlb <n>: \tset second-level TLB entries to <n> (also -tlb)\n");
+       printf("\t-tlba <a>: \tset L1 TLB associativity to <a> (also -tlb)\n");
+       printf("\t-stlba <a>: \tset second-level TLB associativity to <a> (also -tlb)\n");
+       printf("\t-ft <file>: \twrite the miss and writeback stream to <file> as text\n");
+       printf("\t-fb <file>: \twrite the miss and writeback stream to <file> as binary\n");
+       printf("\t-j <n>: \tparse text traces with <n> threads (0: serial reader)\n");
+       printf("\t-idx <k>: \tindex the trace every <k> records in <trace>.idx\n");
+       printf("\t-range <s>:<n>: \treplay <n> records from record <s> (also -idx)\n");
+       printf("\t-segs <n>: \tsplit the range into <n> segments replayed in parallel\n");
        exit(0);
      }
      
@@ -93,42 +150,238 @@
      }
  
      if (!strcmp(argv[arg_index], "-wb")) {
-       set_cache_param(CACHE_PARAM_WRITEBACK, value);
+       set_cache_param(CACHE_PARAM_WRITEBACK, 0);
        arg_index += 1;
        continue;
      }
  
      if (!strcmp(argv[arg_index], "-wt")) {
-       set_cache_param(CACHE_PARAM_WRITETHROUGH, value);
+       set_cache_param(CACHE_PARAM_WRITETHROUGH, 0);
        arg_index += 1;
        continue;
      }
  
      if (!strcmp(argv[arg_index], "-wa")) {
-       set_cache_param(CACHE_PARAM_WRITEALLOC, value);
+       set_cache_param(CACHE_PARAM_WRITEALLOC, 0);
        arg_index += 1;
        continue;
      }
  
      if (!strcmp(argv[arg_index], "-nw")) {
-       set_cache_param(CACHE_PARAM_NOWRITEALLOC, value);
+       set_cache_param(CACHE_PARAM_NOWRITEALLOC, 0);
+       arg_index += 1;
+       continue;
+     }
+ 
+     if (!strcmp(argv[arg_index], "-prof")) {
+       value = atoi(argv[arg_index+1]);
+       set_cache_param(CACHE_PARAM_PROFILE, value > 0 ? value : PROFILE_DEFAULT_TOP_K);
+       arg_index += 2;
+       continue;
+     }
+ 
+     if (!strcmp(argv[arg_index], "-ss")) {
+       value = atoi(argv[arg_index+1]);
+       set_cache_param(CACHE_PARAM_SECTOR_SIZE, value);
+       arg_index += 2;
+       continue;
+     }
+ 
+     if (!strcmp(argv[arg_index], "-vc")) {
+       value = atoi(argv[arg_index+1]);
+       set_cache_param(CACHE_PARAM_VICTIM, value);
+       arg_index += 2;
+       continue;
+     }
+ 
+     if (!strcmp(argv[arg_index], "-wcb")) {
+       value = atoi(argv[arg_index+1]);
+       set_cache_param(CACHE_PARAM_WCB, value);
+       arg_index += 2;
+       continue;
+     }
+ 
+     if (!strcmp(argv[arg_index], "-hl")) {
+       value = atoi(argv[arg_index+1]);
+       set_timing_param(TIMING_PARAM_HIT_LATENCY, value);
+       arg_index += 2;
+       continue;
+     }
+ 
+     if (!strcmp(argv[arg_index], "-mp")) {
+       value = atoi(argv[arg_index+1]);
+       set_timing_param(TIMING_PARAM_MISS_PENALTY, value);
+       arg_index += 2;
+       continue;
+     }
+ 
+     if (!strcmp(argv[arg_index], "-mbw")) {
+       value = atoi(argv[arg_index+1]);
+       set_timing_param(TIMING_PARAM_MEM_BANDWIDTH, value);
+       arg_index += 2;
+       continue;
+     }
+ 
+     if (!strcmp(argv[arg_index], "-wbuf")) {
+       value = atoi(argv[arg_index+1]);
+       set_timing_param(TIMING_PARAM_WRITE_BUFFER, value);
+       arg_index += 2;
+       continue;
+     }
+ 
+     if (!strcmp(argv[arg_index], "-notiming")) {
+       set_cache_param(CACHE_PARAM_TIMING, FALSE);
        arg_index += 1;
        continue;
      }
  
+     if (!strcmp(argv[arg_index], "-tlb")) {
+       useTlb = TRUE;
+       arg_index += 1;
+       continue;
+     }
+ 
+     if (!strcmp(argv[arg_index], "-pg")) {
+       value = atoi(argv[arg_index+1]);
+       set_tlb_param(TLB_PARAM_PAGE_SIZE, value);
+       useTlb = TRUE;
+       arg_index += 2;
+       continue;
+     }
+ 
+     if (!strcmp(argv[arg_index], "-itlb")) {
+       value = atoi(argv[arg_index+1]);
+       set_tlb_param(TLB_PARAM_ITLB_ENTRIES, value);
+       useTlb = TRUE;
+       arg_index += 2;
+       continue;
+     }
+ 
+     if (!strcmp(argv[arg_index], "-dtlb")) {
+       value = atoi(argv[arg_index+1]);
+       set_tlb_param(TLB_PARAM_DTLB_ENTRIES, value);
+       useTlb = TRUE;
+       arg_index += 2;
+       continue;
+     }
+ 
+     if (!strcmp(argv[arg_index], "-stlb")) {
+       value = atoi(argv[arg_index+1]);
+       set_tlb_param(TLB_PARAM_STLB_ENTRIES, value);
+       useTlb = TRUE;
+       arg_index += 2;
+       continue;
+     }
+ 
+     if (!strcmp(argv[arg_index], "-tlba")) {
+       value = atoi(argv[arg_index+1]);
+       set_tlb_param(TLB_PARAM_L1_ASSOC, value);
+       useTlb = TRUE;
+       arg_index += 2;
+       continue;
+     }
+ 
+     if (!strcmp(argv[arg_index], "-stlba")) {
+       value = atoi(argv[arg_index+1]);
+       set_tlb_param(TLB_PARAM_STLB_ASSOC, value);
+       useTlb = TRUE;
+       arg_index += 2;
+       continue;
+     }
+ 
+     if (!strcmp(argv[arg_index], "-ft") || !strcmp(argv[arg_index], "-fb")) {
+       filter_open(argv[arg_index+1], !strcmp(argv[arg_index], "-fb"));
+       set_cache_param(CACHE_PARAM_FILTER, TRUE);
+       useFilter = TRUE;
+       arg_index += 2;
+       continue;
+     }
+ 
+     if (!strcmp(argv[arg_index], "-j")) {
+       parseThreads = atoi(argv[arg_index+1]);
+       arg_index += 2;
+       continue;
+     }
+
+     if (!strcmp(argv[arg_index], "-idx")) {
+       indexInterval = strtoull(argv[arg_index+1], NULL, 10);
+       useIndex = TRUE;
+       arg_index += 2;
+       continue;
+     }
+
+     if (!strcmp(argv[arg_index], "-range")) {
+       char *colon;
+       rangeStart = strtoull(argv[arg_index+1], &colon, 10);
+       rangeCount = (*colon == ':') ? strtoull(colon + 1, NULL, 10) : 0;
+       useIndex = TRUE;
+       useRange = TRUE;
+       arg_index += 2;
+       continue;
+     }
+
+     if (!strcmp(argv[arg_index], "-segs")) {
+       traceSegments = atoi(argv[arg_index+1]);
+       if (traceSegments < 1 || traceSegments > MAX_TRACE_SEGMENTS) {
+         printf("error:  -segs must be between 1 and %d\n", MAX_TRACE_SEGMENTS);
+         exit(-1);
+       }
+       useIndex = TRUE;
+       arg_index += 2;
+       continue;
+     }
+
      printf("error:  unrecognized flag %s\n", argv[arg_index]);
      exit(-1);
  
    }
  
    dump_settings();
+   if (useTlb)
+     dump_tlb_settings();
  
+   if (traceSegments > 1 && useFilter) {
+     printf("error:  -segs cannot be combined with -ft or -fb\n");
+     exit(-1);
+   }
+
    /* open the trace file */
-   traceFile = fopen(argv[arg_index], "r");
+   traceName = argv[arg_index];
+   traceFile = fopen(traceName, "r");
    if (traceFile == NULL) {
     perror("Error opening trace file");
     exit(EXIT_FAILURE);
   }
+
+   /* binary traces are recognized by their magic, text ones are rewound */
+   {
+     char magic[TRACE_BINARY_MAGIC_SIZE];
+     traceBinary = fread(magic, 1, TRACE_BINARY_MAGIC_SIZE, traceFile) == TRACE_BINARY_MAGIC_SIZE &&
+                   !memcmp(magic, TRACE_BINARY_MAGIC, TRACE_BINARY_MAGIC_SIZE);
+     if (!traceBinary)
+       rewind(traceFile);
+   }
+
+   /* the index resolves the range and lets play_trace seek to it */
+   if (useIndex) {
+     traceIndex = trace_load_index(traceFile, traceName, traceBinary, indexInterval);
+     dump_trace_index(traceIndex);
+     if (useRange && rangeStart >= traceIndex->n_records) {
+       printf("error:  range starts past the %llu records of the trace\n",
+              traceIndex->n_records);
+       exit(-1);
+     }
+     if (rangeCount == 0 || rangeCount > traceIndex->n_records - rangeStart)
+       rangeCount = traceIndex->n_records - rangeStart;
+     if (rangeCount)
+       printf("  Range: \t%llu to %llu\n", rangeStart, rangeStart + rangeCount - 1);
+     else
+       printf("  Range: \tempty\n");
+
+     /* no empty segments */
+     if ((unsigned long long)traceSegments > rangeCount)
+       traceSegments = rangeCount ? (int)rangeCount : 1;
+   }
  
    return;
  }
@@ -138,29 +391,158 @@
  void play_trace(inFile)
    FILE *inFile;
  {
-   unsigned addr, data, access_type;
-   int num_inst;
+   unsigned addr, access_type;
+   int num_inst, threads;
+   Ptrace_record records;
+   long n, i;
+   unsigned long long skip, remaining, offset;
  
    num_inst = 0;
-   while(read_trace_element(inFile, &access_type, &addr)) {
+   skip = 0;
+   offset = 0;
+   remaining = ~0ULL;
+   if (traceIndex != NULL) {
+     remaining = rangeCount;
+     if (remaining)
+       skip = trace_seek(inFile, traceIndex, rangeStart, &offset);
+   }
+
+   threads = (parseThreads < 0) ? default_parse_threads() : parseThreads;
+   if (!traceBinary && threads > 0 && trace_map(inFile, threads, offset)) {
+     /* text trace decoded in parallel chunks, replayed in trace order */
+     while (remaining && trace_next_batch(&records, &n))
+       for (i = 0; i < n && remaining; i++) {
+         if (skip) {
+           skip--;
+           continue;
+         }
+         play_element(records[i].access_type, records[i].addr, &num_inst);
+         remaining--;
+       }
+     trace_unmap();
+   } else {
+     while(remaining && read_trace_element(inFile, &access_type, &addr)) {
+       if (skip) {
+         skip--;
+         continue;
+       }
+       play_element(access_type, addr, &num_inst);
+       remaining--;
+     }
+   }
  
-     switch (access_type) {
-     case TRACE_DATA_LOAD:
-     case TRACE_DATA_STORE:
-     case TRACE_INST_LOAD:
-       perform_access(addr, access_type);
-       break;
+   flush();
+ }
+ /************************************************************/
+ 
+ /************************************************************/
+ /*
+  * replays each segment of the range in its own process from a cold
+  * cache, at most one process per CPU at a time, then prints their
+  * reports in order
+  */
+ void play_segments()
+ {
+   FILE *out[MAX_TRACE_SEGMENTS];
+   pid_t pid[MAX_TRACE_SEGMENTS];
+   int status[MAX_TRACE_SEGMENTS];
+   unsigned long long start[MAX_TRACE_SEGMENTS + 1];
+   int s, jobs, waited, threads, failed;
+   char buf[4096];
+   size_t n;
+ 
+   for (s = 0; s <= traceSegments; s++)
+     start[s] = rangeStart + rangeCount * s / traceSegments;
+   jobs = default_parse_threads();
+   if (jobs > traceSegments)
+     jobs = traceSegments;
+   threads = parseThreads;
+   if (threads < 0)
+     threads = (default_parse_threads() + jobs - 1) / jobs;
+   fflush(stdout);
  
-     default:
-       printf("skipping access, unknown type(%d)\n", access_type);
+   waited = 0;
+   for (s = 0; s < traceSegments; s++) {
+     if (s - waited == jobs) {
+       waitpid(pid[waited], &status[waited], 0);
+       waited++;
      }
+     out[s] = tmpfile();
+     if (out[s] == NULL) {
+       perror("Error creating segment output");
+       exit(EXIT_FAILURE);
+     }
+     pid[s] = fork();
+     if (pid[s] < 0) {
+       perror("Error starting segment");
+       exit(EXIT_FAILURE);
+     }
+     if (pid[s] == 0) {
+       /* own stream position, own report */
+       dup2(fileno(out[s]), STDOUT_FILENO);
+       fclose(traceFile);
+       traceFile = fopen(traceName, "r");
+       if (traceFile == NULL) {
+         perror("Error opening trace file");
+         exit(EXIT_FAILURE);
+       }
+       rangeStart = start[s];
+       rangeCount = start[s + 1] - start[s];
+       parseThreads = threads;
+       init_cache();
+       if (useTlb)
+         init_tlb();
+       play_trace(traceFile);
+       print_stats();
+       if (useTlb)
+         print_tlb_stats();
+       trace_free_index(traceIndex);
+       fflush(stdout);
+       _exit(0);
+     }
+   }
+   for (; waited < traceSegments; waited++)
+     waitpid(pid[waited], &status[waited], 0);
  
-     num_inst++;
-     if (!(num_inst % PRINT_INTERVAL))
-       printf("processed %d references\n", num_inst);
+   failed = FALSE;
+   for (s = 0; s < traceSegments; s++) {
+     printf("\n*** SEGMENT %d: RECORDS %llu TO %llu ***\n", s, start[s],
+            start[s + 1] - 1);
+     rewind(out[s]);
+     while ((n = fread(buf, 1, sizeof(buf), out[s])) > 0)
+       fwrite(buf, 1, n, stdout);
+     fclose(out[s]);
+     if (!WIFEXITED(status[s]) || WEXITSTATUS(status[s]) != 0) {
+       printf("error:  segment %d failed\n", s);
+       failed = TRUE;
+     }
    }
+   if (failed)
+     exit(-1);
+ }
+ /************************************************************/
  
-   flush();
+ /************************************************************/
+ void play_element(access_type, addr, num_inst)
+   unsigned access_type, addr;
+   int *num_inst;
+ {
+   switch (access_type) {
+   case TRACE_DATA_LOAD:
+   case TRACE_DATA_STORE:
+   case TRACE_INST_LOAD:
+     if (useTlb)
+       tlb_access(addr, access_type);
+     perform_access(addr, access_type);
+     break;
+ 
+   default:
+     printf("skipping access, unknown type(%d)\n", access_type);
+   }
+ 
+   (*num_inst)++;
+   if (!(*num_inst % PRINT_INTERVAL))
+     printf("processed %d references\n", *num_inst);
  }
  /************************************************************/
  
@@ -172,6 +554,15 @@
    int result;
    char c;
  
+   if (traceBinary) {
+     trace_record record;
+     if (fread(&record, sizeof(trace_record), 1, inFile) != 1)
+       return(0);
+     *access_type = record.access_type;
+     *addr = record.addr;
+     return(1);
+   }
+ 
    result = fscanf(inFile, "%u %x%c", access_type, addr, &c);
    while (c != '\n') {
      result = fscanf(inFile, "%c", &c);
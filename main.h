@@ -9,8 +9,21 @@
 #define TRACE_INST_LOAD 2
 
 #define PRINT_INTERVAL 100000
+#define MAX_TRACE_SEGMENTS 256
+
+/* binary traces start with this magic, followed by packed trace_record's */
+#define TRACE_BINARY_MAGIC "CSIMTRC1"
+#define TRACE_BINARY_MAGIC_SIZE 8
+
+/* one decoded trace reference */
+typedef struct trace_record_ {
+  unsigned access_type;
+  unsigned addr;
+} trace_record, *Ptrace_record;
 
 void parse_args();
 void play_trace();
+void play_segments();
+void play_element();
 int read_trace_element();
 
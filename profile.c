@@ -0,0 +1,310 @@
+/*
+ * profile.c
+ *
+ * Miss attribution.  Misses are counted per block and per page in
+ * count-min sketches, with a top-K min-heap tracking the heaviest keys,
+ * so memory stays fixed no matter how long the trace is.  A small open
+ * addressing table maps each key in the heap to its position, so a miss
+ * finds its entry without scanning the heap.  Misses and
+ * replacements per set are exact, since they are bounded by the cache
+ * geometry.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "profile.h"
+
+#define SKETCH_WIDTH (1 << PROFILE_SKETCH_WIDTH_BITS)
+
+/* odd multipliers, one multiply-shift hash per sketch row */
+static const unsigned long long row_seeds[PROFILE_SKETCH_DEPTH] = {
+  0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL,
+  0x165667B19E3779F9ULL, 0xD6E8FEB86659FD93ULL
+};
+
+static profile_sketch block_sketch;
+static profile_sketch page_sketch;
+static int block_bits;
+static int n_sets[2];
+static unsigned *set_misses[2];
+static unsigned *set_replacements[2];
+static unsigned total_misses;
+
+/************************************************************/
+static void sketch_init(Pprofile_sketch s, int top_k)
+{
+  unsigned n_slots = 1;
+
+  while (n_slots < 2 * (unsigned)top_k)
+    n_slots <<= 1;
+  s->counters = (unsigned *)calloc(PROFILE_SKETCH_DEPTH * SKETCH_WIDTH, sizeof(unsigned));
+  s->heap = (Pprofile_entry)malloc(sizeof(profile_entry) * top_k);
+  s->slots = (int *)malloc(sizeof(int) * n_slots);
+  if (s->counters == NULL || s->heap == NULL || s->slots == NULL)
+  {
+    printf("error profile_init: out of memory\n");
+    exit(-1);
+  }
+  memset(s->slots, -1, sizeof(int) * n_slots);
+  s->slots_mask = n_slots - 1;
+  s->heap_size = 0;
+  s->top_k = top_k;
+}
+/************************************************************/
+
+/************************************************************/
+static unsigned slot_home(Pprofile_sketch s, unsigned key)
+{
+  return (unsigned)((((unsigned long long)key + 1) * row_seeds[0]) >> 32) & s->slots_mask;
+}
+
+/* the slot holding key, or the free slot where it would go */
+static unsigned slot_find(Pprofile_sketch s, unsigned key)
+{
+  unsigned i = slot_home(s, key);
+
+  while (s->slots[i] >= 0 && s->heap[s->slots[i]].key != key)
+    i = (i + 1) & s->slots_mask;
+  return i;
+}
+
+/* frees slot i, shifting back the keys probed past it */
+static void slot_remove(Pprofile_sketch s, unsigned i)
+{
+  unsigned j = i;
+
+  for (;;)
+  {
+    j = (j + 1) & s->slots_mask;
+    if (s->slots[j] < 0)
+      break;
+    if (((j - slot_home(s, s->heap[s->slots[j]].key)) & s->slots_mask) >=
+        ((j - i) & s->slots_mask))
+    {
+      s->slots[i] = s->slots[j];
+      i = j;
+    }
+  }
+  s->slots[i] = -1;
+}
+
+/* swaps two heap entries and keeps their slots pointing at them */
+static void heap_swap(Pprofile_sketch s, int a, int b)
+{
+  unsigned slot_a = slot_find(s, s->heap[a].key);
+  unsigned slot_b = slot_find(s, s->heap[b].key);
+  profile_entry tmp = s->heap[a];
+
+  s->heap[a] = s->heap[b];
+  s->heap[b] = tmp;
+  s->slots[slot_a] = b;
+  s->slots[slot_b] = a;
+}
+/************************************************************/
+
+/************************************************************/
+static void sift_down(Pprofile_sketch s, int i)
+{
+  for (;;)
+  {
+    int l = 2 * i + 1, r = l + 1, m = i;
+    if (l < s->heap_size && s->heap[l].count < s->heap[m].count)
+      m = l;
+    if (r < s->heap_size && s->heap[r].count < s->heap[m].count)
+      m = r;
+    if (m == i)
+      return;
+    heap_swap(s, i, m);
+    i = m;
+  }
+}
+
+static void sift_up(Pprofile_sketch s, int i)
+{
+  while (i > 0 && s->heap[(i - 1) / 2].count > s->heap[i].count)
+  {
+    heap_swap(s, i, (i - 1) / 2);
+    i = (i - 1) / 2;
+  }
+}
+/************************************************************/
+
+/************************************************************/
+/* counts one miss on key and keeps the heap of heavy hitters current */
+static void sketch_add(Pprofile_sketch s, unsigned key)
+{
+  unsigned estimate = ~0u, slot;
+
+  for (int row = 0; row < PROFILE_SKETCH_DEPTH; row++)
+  {
+    unsigned col = (unsigned)((((unsigned long long)key + 1) * row_seeds[row]) >>
+                              (64 - PROFILE_SKETCH_WIDTH_BITS));
+    unsigned *counter = &s->counters[row * SKETCH_WIDTH + col];
+    (*counter)++;
+    if (*counter < estimate)
+      estimate = *counter;
+  }
+
+  slot = slot_find(s, key);
+  if (s->slots[slot] >= 0)
+  { /* estimates only grow, so the entry can only move down */
+    int i = s->slots[slot];
+    s->heap[i].count = estimate;
+    sift_down(s, i);
+    return;
+  }
+
+  if (s->heap_size < s->top_k)
+  {
+    s->heap[s->heap_size].key = key;
+    s->heap[s->heap_size].count = estimate;
+    s->slots[slot] = s->heap_size;
+    sift_up(s, s->heap_size++);
+  }
+  else if (estimate > s->heap[0].count)
+  { /* the lightest key leaves the heap */
+    slot_remove(s, slot_find(s, s->heap[0].key));
+    s->heap[0].key = key;
+    s->heap[0].count = estimate;
+    s->slots[slot_find(s, key)] = 0;
+    sift_down(s, 0);
+  }
+}
+/************************************************************/
+
+/************************************************************/
+void profile_init(int top_k, int n_sets_c1, int n_sets_c2, int block_offset_bits)
+{
+  if (top_k > PROFILE_MAX_TOP_K)
+    top_k = PROFILE_MAX_TOP_K;
+
+  sketch_init(&block_sketch, top_k);
+  sketch_init(&page_sketch, top_k);
+  block_bits = block_offset_bits;
+  n_sets[0] = n_sets_c1;
+  n_sets[1] = n_sets_c2;
+  for (int which = 0; which < 2; which++)
+  {
+    set_misses[which] = (unsigned *)calloc(n_sets[which] + 1, sizeof(unsigned));
+    set_replacements[which] = (unsigned *)calloc(n_sets[which] + 1, sizeof(unsigned));
+    if (set_misses[which] == NULL || set_replacements[which] == NULL)
+    {
+      printf("error profile_init: out of memory\n");
+      exit(-1);
+    }
+  }
+  total_misses = 0;
+}
+/************************************************************/
+
+/************************************************************/
+void profile_miss(unsigned addr, int which, unsigned set, int replaced)
+{
+  total_misses++;
+  sketch_add(&block_sketch, addr >> block_bits);
+  sketch_add(&page_sketch, addr / PROFILE_PAGE_SIZE);
+  set_misses[which][set]++;
+  if (replaced)
+    set_replacements[which][set]++;
+}
+/************************************************************/
+
+/************************************************************/
+static int by_count_desc(const void *a, const void *b)
+{
+  unsigned ca = ((const profile_entry *)a)->count;
+  unsigned cb = ((const profile_entry *)b)->count;
+  if (ca != cb)
+    return ca < cb ? 1 : -1;
+  return ((const profile_entry *)a)->key < ((const profile_entry *)b)->key ? -1 : 1;
+}
+
+static void report_sketch(Pprofile_sketch s, const char *title, int shift)
+{
+  profile_entry ranked[PROFILE_MAX_TOP_K];
+
+  memcpy(ranked, s->heap, sizeof(profile_entry) * s->heap_size);
+  qsort(ranked, s->heap_size, sizeof(profile_entry), by_count_desc);
+  printf(" %s\n", title);
+  for (int i = 0; i < s->heap_size; i++)
+    printf("  %3d  0x%08x  misses %u (%2.2f%%)\n", i + 1,
+           ranked[i].key << shift, ranked[i].count,
+           100.0 * ranked[i].count / (total_misses ? total_misses : 1));
+}
+/************************************************************/
+
+/************************************************************/
+void profile_report(int split)
+{
+  profile_entry ranked[PROFILE_MAX_TOP_K];
+  int top_k = block_sketch.top_k, n = 0;
+  int page_shift = 0;
+
+  while ((1 << page_shift) < PROFILE_PAGE_SIZE)
+    page_shift++;
+
+  printf("\n*** MISS ATTRIBUTION ***\n");
+  printf("  misses profiled: %u\n", total_misses);
+  report_sketch(&block_sketch, "HOTTEST MISSING BLOCKS (upper-bound estimates)", block_bits);
+  report_sketch(&page_sketch, "HOTTEST MISSING PAGES (upper-bound estimates)", page_shift);
+
+  /* most contended sets by replacements, which is where conflicts show */
+  printf(" MOST CONTENDED SETS\n");
+  for (int which = 0; which < 2; which++)
+    for (int set = 0; set < n_sets[which]; set++)
+    {
+      unsigned key = ((unsigned)set << 1) | which;
+      unsigned count = set_replacements[which][set];
+      if (count == 0)
+        continue;
+      if (n < top_k)
+        ranked[n++] = (profile_entry){key, count};
+      else
+      {
+        int min = 0;
+        for (int i = 1; i < n; i++)
+          if (ranked[i].count < ranked[min].count)
+            min = i;
+        if (count > ranked[min].count)
+          ranked[min] = (profile_entry){key, count};
+      }
+    }
+  qsort(ranked, n, sizeof(profile_entry), by_count_desc);
+  for (int i = 0; i < n; i++)
+  {
+    int which = ranked[i].key & 1;
+    unsigned set = ranked[i].key >> 1;
+    printf("  %3d  %s set %u  replacements %u  misses %u\n", i + 1,
+           split ? (which ? "D-cache" : "I-cache") : "cache", set,
+           ranked[i].count, set_misses[which][set]);
+  }
+
+  printf("  profiler memory: %lu bytes\n",
+         (unsigned long)(2 * (PROFILE_SKETCH_DEPTH * SKETCH_WIDTH * sizeof(unsigned) +
+                              top_k * sizeof(profile_entry) +
+                              (block_sketch.slots_mask + 1) * sizeof(int)) +
+                         2 * sizeof(unsigned) * (n_sets[0] + n_sets[1] + 2)));
+}
+/************************************************************/
+
+/************************************************************/
+void profile_free()
+{
+  free(block_sketch.counters);
+  free(block_sketch.heap);
+  free(page_sketch.counters);
+  free(page_sketch.heap);
+  free(block_sketch.slots);
+  free(page_sketch.slots);
+  for (int which = 0; which < 2; which++)
+  {
+    free(set_misses[which]);
+    free(set_replacements[which]);
+    set_misses[which] = set_replacements[which] = NULL;
+  }
+  memset(&block_sketch, 0, sizeof(profile_sketch));
+  memset(&page_sketch, 0, sizeof(profile_sketch));
+}
+/************************************************************/
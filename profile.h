@@ -0,0 +1,34 @@
+/*
+ * profile.h
+ */
+
+
+/* default profiler parameters--can be changed */
+#define PROFILE_DEFAULT_TOP_K 16
+#define PROFILE_MAX_TOP_K 1024
+#define PROFILE_PAGE_SIZE 4096
+#define PROFILE_SKETCH_DEPTH 4
+#define PROFILE_SKETCH_WIDTH_BITS 16
+
+
+/* structure definitions */
+typedef struct profile_entry_ {
+  unsigned key;			/* block or page number */
+  unsigned count;		/* sketch estimate of its misses */
+} profile_entry, *Pprofile_entry;
+
+typedef struct profile_sketch_ {
+  unsigned *counters;		/* count-min sketch, DEPTH rows of 2^WIDTH_BITS */
+  Pprofile_entry heap;		/* min-heap of the top_k heaviest keys */
+  int heap_size;
+  int top_k;
+  int *slots;			/* heap position of each key, -1 if free */
+  unsigned slots_mask;		/* slots is a power of two, at least 2 top_k */
+} profile_sketch, *Pprofile_sketch;
+
+
+/* function prototypes */
+void profile_init(int top_k, int n_sets_c1, int n_sets_c2, int block_offset_bits);
+void profile_miss(unsigned addr, int which, unsigned set, int replaced);
+void profile_report(int split);
+void profile_free();
@@ -0,0 +1,665 @@
+/*
+ * refcache.c
+ *
+ * Reference model for the differential verifier: a frozen copy of the
+ * original linked-list implementation of perform_access().  Do not
+ * optimize this file; it defines the counters every engine must match.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+
+#include "cache.h"
+#include "main.h"
+#include "refcache.h"
+
+static void ref_delete();
+static void ref_insert();
+
+/* cache configuration parameters */
+static int cache_split = 0;
+static int cache_usize = DEFAULT_CACHE_SIZE;
+static int cache_isize = DEFAULT_CACHE_SIZE;
+static int cache_dsize = DEFAULT_CACHE_SIZE;
+static int cache_block_size = DEFAULT_CACHE_BLOCK_SIZE;
+static int words_per_block = DEFAULT_CACHE_BLOCK_SIZE / WORD_SIZE;
+static int cache_assoc = DEFAULT_CACHE_ASSOC;
+static int cache_writeback = DEFAULT_CACHE_WRITEBACK;
+static int cache_writealloc = DEFAULT_CACHE_WRITEALLOC;
+
+/* cache model data structures */
+static ref_cache c1;
+static ref_cache c2;
+static cache_stat cache_stat_inst;
+static cache_stat cache_stat_data;
+
+/************************************************************/
+void ref_set_cache_param(param, value) int param;
+int value;
+{
+
+  switch (param)
+  {
+  case CACHE_PARAM_BLOCK_SIZE:
+    cache_block_size = value;
+    words_per_block = value / WORD_SIZE;
+    break;
+  case CACHE_PARAM_USIZE:
+    cache_split = FALSE;
+    cache_usize = value;
+    break;
+  case CACHE_PARAM_ISIZE:
+    cache_split = TRUE;
+    cache_isize = value;
+    break;
+  case CACHE_PARAM_DSIZE:
+    cache_split = TRUE;
+    cache_dsize = value;
+    break;
+  case CACHE_PARAM_ASSOC:
+    cache_assoc = value;
+    break;
+  case CACHE_PARAM_WRITEBACK:
+    cache_writeback = TRUE;
+    break;
+  case CACHE_PARAM_WRITETHROUGH:
+    cache_writeback = FALSE;
+    break;
+  case CACHE_PARAM_WRITEALLOC:
+    cache_writealloc = TRUE;
+    break;
+  case CACHE_PARAM_NOWRITEALLOC:
+    cache_writealloc = FALSE;
+    break;
+  default:
+    printf("error ref_set_cache_param: bad parameter value\n");
+    exit(-1);
+  }
+}
+/************************************************************/
+
+/************************************************************/
+void ref_init_cache()
+{
+
+  /* Instruction cache statistics */
+  cache_stat_inst.accesses = 0;     /* number of memory references */
+  cache_stat_inst.misses = 0;        /* number of cache misses */
+  cache_stat_inst.replacements = 0;  /* number of misses that cause replacments */
+  cache_stat_inst.demand_fetches = 0; /* number of fetches */
+  cache_stat_inst.copies_back = 0;    /* number of write backs */
+
+  /* Data cache statistics */
+  cache_stat_data.accesses = 0;
+  cache_stat_data.misses = 0;
+  cache_stat_data.replacements = 0;
+  cache_stat_data.demand_fetches = 0;
+  cache_stat_data.copies_back = 0;
+
+  /* Unified case, I'll use c1 as the unified one */
+  if (cache_split == 0)
+  {
+    c1.size = cache_usize;
+    c1.associativity = cache_assoc;
+    c1.n_sets = cache_usize / (cache_assoc * cache_block_size);
+    c1.index_mask_offset = (int)LOG2(cache_block_size);
+    c1.index_mask = (c1.n_sets - 1) << c1.index_mask_offset; /* (addr & index_mask) >> index_mask_offset would show the index bits */
+    /* I could get the tag with (addr) >> (c1.index_mask_offset + LOG2(c1.n_sets)) which is a right shift in the address by the number of index and offset bits */
+    c1.LRU_head = (Pref_cache_line *)malloc(sizeof(Pref_cache_line) * c1.n_sets);
+    c1.LRU_tail = (Pref_cache_line *)malloc(sizeof(Pref_cache_line) * c1.n_sets);
+    c1.set_contents = (int *)malloc(sizeof(int) * c1.n_sets);
+
+    /* We also need to initialize the LRU structure to NULL's and the contents of the cache to 0*/
+    for (int i = 0; i < c1.n_sets; i++)
+    {
+      c1.LRU_head[i] = NULL;
+      c1.LRU_tail[i] = NULL;
+      c1.set_contents[i] = 0;
+    }
+    c1.contents = 0;
+  }
+  else
+  { /* split cache, c1 for instructions using cache_isize, and c2 for data using cache_dsize*/
+
+    /* Instruction cache */
+    c1.size = cache_isize;
+    c1.associativity = cache_assoc;
+    c1.n_sets = cache_isize / (cache_assoc * cache_block_size);
+    c1.index_mask_offset = (int)LOG2(cache_block_size);
+    c1.index_mask = (c1.n_sets - 1) << c1.index_mask_offset;
+    c1.LRU_head = (Pref_cache_line *)malloc(sizeof(Pref_cache_line) * c1.n_sets);
+    c1.LRU_tail = (Pref_cache_line *)malloc(sizeof(Pref_cache_line) * c1.n_sets);
+    c1.set_contents = (int *)malloc(sizeof(int) * c1.n_sets);
+    for (int i = 0; i < c1.n_sets; i++)
+    {
+      c1.LRU_head[i] = NULL;
+      c1.LRU_tail[i] = NULL;
+      c1.set_contents[i] = 0;
+    }
+    c1.contents = 0;
+
+    /* Data cache*/
+    c2.size = cache_dsize;
+    c2.associativity = cache_assoc;
+    c2.n_sets = cache_dsize / (cache_assoc * cache_block_size);
+    c2.index_mask_offset = (int)LOG2(cache_block_size);
+    c2.index_mask = (c2.n_sets - 1) << c2.index_mask_offset;
+    c2.LRU_head = (Pref_cache_line *)malloc(sizeof(Pref_cache_line) * c2.n_sets);
+    c2.LRU_tail = (Pref_cache_line *)malloc(sizeof(Pref_cache_line) * c2.n_sets);
+    c2.set_contents = (int *)malloc(sizeof(int) * c2.n_sets);
+    for (int i = 0; i < c2.n_sets; i++)
+    {
+      c2.LRU_head[i] = NULL;
+      c2.LRU_tail[i] = NULL;
+      c2.set_contents[i] = 0;
+    }
+    c2.contents = 0;
+  }
+}
+/************************************************************/
+
+/************************************************************/
+void ref_perform_access(unsigned addr, unsigned access_type)
+{
+  unsigned words_in_block;
+
+  if (cache_split == 0)
+  { /* Unified cache case */
+    words_in_block = (c1.size > 0) ? (cache_block_size / WORD_SIZE) : 0;
+
+    /* Register the access */
+    if (access_type == TRACE_INST_LOAD)
+      cache_stat_inst.accesses++;
+    else
+      cache_stat_data.accesses++;
+
+    /* getting the tag, index, and offset */
+    unsigned tag = addr >> (c1.index_mask_offset + LOG2(c1.n_sets));
+    unsigned index = (addr & c1.index_mask) >> c1.index_mask_offset;
+
+    if (c1.associativity == 1)
+    { /* Direct-mapped unified cache case*/
+      Pref_cache_line line = c1.LRU_head[index];
+      if (line != NULL && line->tag == tag)
+      { /* cache hit case */
+        if (access_type == TRACE_DATA_STORE)
+        {
+          if (cache_writeback)
+            line->dirty = 1;
+          else
+            cache_stat_data.copies_back += 1;
+        }
+        ref_delete(&c1.LRU_head[index], &c1.LRU_tail[index], line);
+        ref_insert(&c1.LRU_head[index], &c1.LRU_tail[index], line);
+      }
+      else
+      { /*cache miss case */
+        if (access_type == TRACE_INST_LOAD)
+        {
+          cache_stat_inst.misses++;
+          cache_stat_inst.demand_fetches += words_in_block;
+        }
+        else
+        { /* data store miss */
+          if (cache_writealloc)
+          {
+            cache_stat_data.misses++;
+            cache_stat_data.demand_fetches += words_in_block;
+          }
+          else
+          {
+            cache_stat_data.misses++;
+            if (cache_writeback)
+              cache_stat_data.copies_back += words_in_block;
+            else
+              cache_stat_data.copies_back += 1;
+            return;
+          }
+        }
+        if (line != NULL)
+        {
+          if (line->dirty == 1 && cache_writeback)
+            cache_stat_data.copies_back += words_in_block;
+          if (access_type == TRACE_INST_LOAD)
+            cache_stat_inst.replacements++;
+          else
+            cache_stat_data.replacements++;
+          ref_delete(&c1.LRU_head[index], &c1.LRU_tail[index], line);
+          free(line);
+        }
+        Pref_cache_line new_line = (Pref_cache_line)malloc(sizeof(ref_cache_line));
+        new_line->tag = tag;
+        new_line->dirty = (access_type == TRACE_DATA_STORE) ? (cache_writeback ? 1 : 0) : 0;
+        new_line->LRU_next = NULL;
+        new_line->LRU_prev = NULL;
+        ref_insert(&c1.LRU_head[index], &c1.LRU_tail[index], new_line);
+        c1.set_contents[index] = 1;
+      }
+    }
+    else
+    { /* set-associative unified cachecase */
+      Pref_cache_line curr = c1.LRU_head[index];
+      Pref_cache_line hit_line = NULL;
+      while (curr != NULL)
+      {
+        if (curr->tag == tag)
+        {
+          hit_line = curr;
+          break;
+        }
+        curr = curr->LRU_next;
+      }
+      if (hit_line != NULL)
+      { /* Cache hit */
+        if (access_type == TRACE_DATA_STORE)
+        {
+          if (cache_writeback)
+            hit_line->dirty = 1;
+          else
+            cache_stat_data.copies_back += 1;
+        }
+        ref_delete(&c1.LRU_head[index], &c1.LRU_tail[index], hit_line);
+        ref_insert(&c1.LRU_head[index], &c1.LRU_tail[index], hit_line);
+      }
+      else
+      { /* cache miss case */
+        if (access_type == TRACE_INST_LOAD)
+        {
+          cache_stat_inst.misses++;
+          cache_stat_inst.demand_fetches += words_in_block;
+        }
+        else
+        {
+          if (cache_writealloc)
+          {
+            cache_stat_data.misses++;
+            cache_stat_data.demand_fetches += words_in_block;
+            if (!cache_writeback)
+              cache_stat_data.copies_back += 1;
+          }
+          else
+          {
+            cache_stat_data.misses++;
+            if (cache_writeback)
+              cache_stat_data.copies_back += words_in_block;
+            else
+              cache_stat_data.copies_back += 1;
+            return;
+          }
+        }
+        if (c1.set_contents[index] >= c1.associativity)
+        {
+          /* LRU eviction from tail */
+          Pref_cache_line victim = c1.LRU_tail[index];
+          if (victim != NULL)
+          {
+            if (victim->dirty == 1 && cache_writeback)
+              cache_stat_data.copies_back += words_in_block;
+            if (access_type == TRACE_INST_LOAD)
+              cache_stat_inst.replacements++;
+            else
+              cache_stat_data.replacements++;
+            ref_delete(&c1.LRU_head[index], &c1.LRU_tail[index], victim);
+            free(victim);
+          }
+        }
+        else
+        {
+          c1.set_contents[index]++;
+        }
+        Pref_cache_line new_line = (Pref_cache_line)malloc(sizeof(ref_cache_line));
+        new_line->tag = tag;
+        new_line->dirty = (access_type == TRACE_DATA_STORE) ? (cache_writeback ? 1 : 0) : 0;
+        new_line->LRU_next = NULL;
+        new_line->LRU_prev = NULL;
+        ref_insert(&c1.LRU_head[index], &c1.LRU_tail[index], new_line);
+      }
+    }
+  }
+  
+  else // splitt caches case
+  {
+    ref_cache *target;
+    cache_stat *target_stat;
+    unsigned local_block_size = cache_block_size;
+    // write policies
+    int wb_local = cache_writeback;
+    int wa_local = cache_writealloc;
+
+    if (access_type == TRACE_INST_LOAD)
+    {
+      target = &c1; // c1 for instruction cache
+      target_stat = &cache_stat_inst;
+    }
+    else
+    {
+      target = &c2; // c2 for the data cache
+      target_stat = &cache_stat_data;
+    }
+    target_stat->accesses++;
+
+    unsigned tag = addr >> (target->index_mask_offset + LOG2(target->n_sets));
+    unsigned index = (addr & target->index_mask) >> target->index_mask_offset;
+    unsigned local_words_in_block = local_block_size / WORD_SIZE;
+
+    if (target->associativity == 1)
+    { /* Direct-mapped split cache */
+      Pref_cache_line line = target->LRU_head[index];
+      if (line != NULL && line->tag == tag)
+      {
+        if (access_type == TRACE_DATA_STORE)
+        {
+          if (wb_local)
+            line->dirty = 1;
+          else
+            target_stat->copies_back += 1;
+        }
+        ref_delete(&target->LRU_head[index], &target->LRU_tail[index], line);
+        ref_insert(&target->LRU_head[index], &target->LRU_tail[index], line);
+      }
+      else
+      {
+        if (access_type == TRACE_INST_LOAD)
+        {
+          target_stat->misses++;
+          target_stat->demand_fetches += local_words_in_block;
+        }
+        else
+        {
+          if (wa_local)
+          {
+            target_stat->misses++;
+            target_stat->demand_fetches += local_words_in_block;
+            if (!wb_local)
+              target_stat->copies_back += 1;
+          }
+          else
+          {
+            target_stat->misses++;
+            if (wb_local)
+              target_stat->copies_back += local_words_in_block;
+            else
+              target_stat->copies_back += 1;
+            ;
+          }
+        }
+        if (line != NULL)
+        {
+          if (line->dirty && wb_local)
+            target_stat->copies_back += local_words_in_block;
+          if (access_type == TRACE_INST_LOAD)
+            target_stat->replacements++;
+          else
+            target_stat->replacements++;
+          ref_delete(&target->LRU_head[index], &target->LRU_tail[index], line);
+          free(line);
+        }
+        {
+          Pref_cache_line new_line = (Pref_cache_line)malloc(sizeof(ref_cache_line));
+          new_line->tag = tag;
+          new_line->dirty = (access_type == TRACE_DATA_STORE) ? (wa_local ? (wb_local ? 1 : 0) : 0) : 0;
+          new_line->LRU_next = NULL;
+          new_line->LRU_prev = NULL;
+          ref_insert(&target->LRU_head[index], &target->LRU_tail[index], new_line);
+          target->set_contents[index] = 1;
+        }
+      }
+    }
+    else
+    { /* set-associative split cache */
+      Pref_cache_line curr = target->LRU_head[index];
+      Pref_cache_line hit_line = NULL;
+      while (curr != NULL)
+      {
+        if (curr->tag == tag)
+        {
+          hit_line = curr;
+          break;
+        }
+        curr = curr->LRU_next;
+      }
+      if (hit_line != NULL)
+      { /* cache hitcase */
+        if (access_type == TRACE_DATA_STORE)
+        {
+          if (wb_local)
+            hit_line->dirty = 1;
+          else
+            target_stat->copies_back += 1;
+        }
+        ref_delete(&target->LRU_head[index], &target->LRU_tail[index], hit_line);
+        ref_insert(&target->LRU_head[index], &target->LRU_tail[index], hit_line);
+      }
+      else
+      { /* cache miss case */
+        if (access_type == TRACE_INST_LOAD)
+        {
+          target_stat->misses++;
+          target_stat->demand_fetches += local_words_in_block;
+        }
+        else
+        {
+          if (wa_local)
+          {
+            target_stat->misses++;
+            target_stat->demand_fetches += local_words_in_block;
+            if (!wb_local)
+              target_stat->copies_back += 1;
+          }
+          else
+          {
+            target_stat->misses++;
+            if (wb_local)
+              target_stat->copies_back += local_words_in_block;
+            else
+              target_stat->copies_back += 1;
+          }
+        }
+        if (target->set_contents[index] >= target->associativity)
+        {
+          Pref_cache_line victim = target->LRU_tail[index]; 
+          if (victim != NULL)
+          {
+            if (victim->dirty && wb_local)
+              target_stat->copies_back += local_words_in_block;
+            target_stat->replacements++;
+            ref_delete(&target->LRU_head[index], &target->LRU_tail[index], victim);
+            free(victim);
+          }
+        }
+        else
+        {
+          target->set_contents[index]++;
+        }
+        {
+          Pref_cache_line new_line = (Pref_cache_line)malloc(sizeof(ref_cache_line));
+          new_line->tag = tag;
+          new_line->dirty = (access_type == TRACE_DATA_STORE) ? (wa_local ? (wb_local ? 1 : 0) : 0) : 0;
+          new_line->LRU_next = NULL;
+          new_line->LRU_prev = NULL;
+          ref_insert(&target->LRU_head[index], &target->LRU_tail[index], new_line);
+        }
+      }
+    }
+  }
+}
+
+/************************************************************/
+
+/************************************************************/
+void ref_flush()
+{
+  unsigned words_in_block = c1.size > 0 ? (unsigned)(cache_block_size / WORD_SIZE) : 0;
+
+  /* flush the cache */
+  if (cache_split == 0)
+  { /* for unified case flush remaining dirty bits and record statistic of copies back, also clean cache*/
+    for (int i = 0; i < c1.n_sets; i++)
+    {
+      Pref_cache_line current = c1.LRU_head[i];
+      while (current != NULL)
+      {
+        if (cache_writeback && current->dirty == 1)
+        {
+          cache_stat_data.copies_back += words_in_block;
+        }
+        Pref_cache_line temp = current;
+        current = current->LRU_next;
+        free(temp);
+      }
+      c1.LRU_head[i] = NULL;
+      c1.LRU_tail[i] = NULL;
+      c1.set_contents[i] = 0;
+    }
+  }
+  else
+  { /* split mode */
+    for (int i = 0; i < c1.n_sets; i++)
+    {
+      Pref_cache_line current = c1.LRU_head[i];
+      while (current != NULL)
+      {
+        if (cache_writeback && current->dirty == 1)
+        {
+          cache_stat_inst.copies_back += words_in_block;
+        }
+        Pref_cache_line temp = current;
+        current = current->LRU_next;
+        free(temp);
+      }
+      c1.LRU_head[i] = NULL;
+      c1.LRU_tail[i] = NULL;
+      c1.set_contents[i] = 0;
+    }
+
+    for (int i = 0; i < c2.n_sets; i++)
+    {
+      Pref_cache_line current = c2.LRU_head[i];
+      while (current != NULL)
+      {
+        if (cache_writeback && current->dirty == 1)
+        {
+          cache_stat_data.copies_back += words_in_block;
+        }
+        Pref_cache_line temp = current;
+        current = current->LRU_next;
+        free(temp);
+      }
+      c2.LRU_head[i] = NULL;
+      c2.LRU_tail[i] = NULL;
+      c2.set_contents[i] = 0;
+    }
+  }
+}
+/************************************************************/
+
+/************************************************************/
+static void ref_delete(head, tail, item)
+    Pref_cache_line *head,
+    *tail;
+Pref_cache_line item;
+{
+  if (item->LRU_prev)
+  {
+    item->LRU_prev->LRU_next = item->LRU_next;
+  }
+  else
+  {
+    /* item at head */
+    *head = item->LRU_next;
+  }
+
+  if (item->LRU_next)
+  {
+    item->LRU_next->LRU_prev = item->LRU_prev;
+  }
+  else
+  {
+    /* item at tail */
+    *tail = item->LRU_prev;
+  }
+}
+/************************************************************/
+
+/************************************************************/
+/* inserts at the head of the list */
+static void ref_insert(head, tail, item)
+    Pref_cache_line *head,
+    *tail;
+Pref_cache_line item;
+{
+  item->LRU_next = *head;
+  item->LRU_prev = (Pref_cache_line)NULL;
+
+  if (item->LRU_next)
+    item->LRU_next->LRU_prev = item;
+  else
+    *tail = item;
+
+  *head = item;
+}
+/************************************************************/
+
+/************************************************************/
+void ref_get_cache_stats(Pcache_stat inst, Pcache_stat data)
+{
+  *inst = cache_stat_inst;
+  *data = cache_stat_data;
+}
+/************************************************************/
+
+/************************************************************/
+/* number of sets in c1 (which == 0) or c2 (which == 1), 0 if unused */
+int ref_get_n_sets(int which)
+{
+  if (which == 0)
+    return c1.n_sets;
+  return cache_split ? c2.n_sets : 0;
+}
+/************************************************************/
+
+/************************************************************/
+/* copies the lines of a set in MRU to LRU order, returns how many */
+int ref_get_set_lines(int which, int set, unsigned *tags, int *dirty)
+{
+  Pref_cache c = (which == 0) ? &c1 : &c2;
+  int n = 0;
+
+  for (Pref_cache_line line = c->LRU_head[set]; line != NULL; line = line->LRU_next)
+  {
+    tags[n] = line->tag;
+    dirty[n] = line->dirty;
+    n++;
+  }
+  return n;
+}
+/************************************************************/
+
+/************************************************************/
+/* releases every line and set array so ref_init_cache() can run again */
+void ref_free_cache()
+{
+  Pref_cache caches[2] = {&c1, &c2};
+
+  for (int k = 0; k < 2; k++)
+  {
+    Pref_cache c = caches[k];
+    for (int i = 0; c->LRU_head != NULL && i < c->n_sets; i++)
+    {
+      Pref_cache_line current = c->LRU_head[i];
+      while (current != NULL)
+      {
+        Pref_cache_line temp = current;
+        current = current->LRU_next;
+        free(temp);
+      }
+    }
+    free(c->LRU_head);
+    free(c->LRU_tail);
+    free(c->set_contents);
+    memset(c, 0, sizeof(ref_cache));
+  }
+}
+/************************************************************/
@@ -0,0 +1,36 @@
+/*
+ * refcache.h
+ */
+
+
+/* structure definitions, as in the original simulator */
+typedef struct ref_cache_line_ {
+  unsigned tag;
+  int dirty;
+
+  struct ref_cache_line_ *LRU_next;
+  struct ref_cache_line_ *LRU_prev;
+} ref_cache_line, *Pref_cache_line;
+
+typedef struct ref_cache_ {
+  int size;			/* cache size */
+  int associativity;		/* cache associativity */
+  int n_sets;			/* number of cache sets */
+  unsigned index_mask;		/* mask to find cache index */
+  int index_mask_offset;	/* number of zero bits in mask */
+  Pref_cache_line *LRU_head;	/* head of LRU list for each set */
+  Pref_cache_line *LRU_tail;	/* tail of LRU list for each set */
+  int *set_contents;		/* number of valid entries in set */
+  int contents;			/* number of valid entries in cache */
+} ref_cache, *Pref_cache;
+
+
+/* function prototypes */
+void ref_set_cache_param();
+void ref_init_cache();
+void ref_perform_access();
+void ref_flush();
+void ref_get_cache_stats();
+int ref_get_n_sets();
+int ref_get_set_lines();
+void ref_free_cache();
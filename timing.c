@@ -0,0 +1,214 @@
+/*
+ * timing.c
+ *
+ * A simple in-order timing model on top of the traffic counters.  Every
+ * reference costs the hit latency; one that fetches a block also waits
+ * for the miss penalty plus the transfer at memory bandwidth.  Words
+ * written to memory (write-through stores, write backs) go through a
+ * bounded write buffer that drains at memory bandwidth and only stalls
+ * the reference that finds it full.  Fetches do not contend with the
+ * draining writes, which keeps the model to a few adds per reference.
+ * The write backs of the final flush queue in the same buffer, and the
+ * run ends when the last of them has drained.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "cache.h"
+#include "timing.h"
+
+/* timing parameters */
+static int hit_latency = DEFAULT_HIT_LATENCY;
+static int miss_penalty = DEFAULT_MISS_PENALTY;
+static int mem_bandwidth = DEFAULT_MEM_BANDWIDTH;
+static int write_buffer = DEFAULT_WRITE_BUFFER;
+
+/* timing state */
+static unsigned long long cycle;
+static unsigned long long window_end;
+static unsigned long long wbuf_done[MAX_WRITE_BUFFER]; /* completion of each write */
+static unsigned long long wbuf_last;	/* completion of the newest write */
+static int wbuf_head;
+static int wbuf_count;
+static unsigned long long flush_words;	/* written back by the final flush */
+static timing_stat timing_stat_inst;
+static timing_stat timing_stat_data;
+
+/************************************************************/
+void set_timing_param(param, value)
+  int param;
+  int value;
+{
+  switch (param)
+  {
+  case TIMING_PARAM_HIT_LATENCY:
+    hit_latency = value;
+    break;
+  case TIMING_PARAM_MISS_PENALTY:
+    miss_penalty = value;
+    break;
+  case TIMING_PARAM_MEM_BANDWIDTH:
+    mem_bandwidth = value;
+    break;
+  case TIMING_PARAM_WRITE_BUFFER:
+    write_buffer = value;
+    break;
+  default:
+    printf("error set_timing_param: bad parameter value\n");
+    exit(-1);
+  }
+  if (hit_latency < 0 || miss_penalty < 0 || mem_bandwidth < 1 ||
+      write_buffer < 1 || write_buffer > MAX_WRITE_BUFFER)
+  {
+    printf("error set_timing_param: value out of range\n");
+    exit(-1);
+  }
+}
+/************************************************************/
+
+/************************************************************/
+void init_timing()
+{
+  cycle = 0;
+  window_end = TIMING_WINDOW;
+  wbuf_last = 0;
+  wbuf_head = 0;
+  wbuf_count = 0;
+  flush_words = 0;
+  timing_stat_inst = (timing_stat){0, 0, 0, 0, 0, 0};
+  timing_stat_data = timing_stat_inst;
+}
+/************************************************************/
+
+/************************************************************/
+/* cycles to move words at memory bandwidth, rounded up */
+static unsigned long long transfer(unsigned words)
+{
+  return ((unsigned long long)words * WORD_SIZE + mem_bandwidth - 1) / mem_bandwidth;
+}
+/************************************************************/
+
+/************************************************************/
+void timing_access(int inst, unsigned fetched, unsigned written)
+{
+  Ptiming_stat stat = inst ? &timing_stat_inst : &timing_stat_data;
+  unsigned long long cycles = hit_latency;
+
+  if (fetched)
+  {
+    unsigned long long stall = miss_penalty + transfer(fetched);
+    stat->miss_stalls += stall;
+    cycles += stall;
+  }
+
+  if (written)
+  {
+    /* retire the writes that have drained by now */
+    while (wbuf_count && wbuf_done[wbuf_head] <= cycle)
+    {
+      wbuf_head = (wbuf_head + 1) % write_buffer;
+      wbuf_count--;
+    }
+    if (wbuf_count == write_buffer)
+    { /* buffer full, wait for the oldest write */
+      unsigned long long stall = wbuf_done[wbuf_head] - cycle;
+      stat->buffer_stalls += stall;
+      cycles += stall;
+      wbuf_head = (wbuf_head + 1) % write_buffer;
+      wbuf_count--;
+    }
+    if (wbuf_last < cycle)
+      wbuf_last = cycle;
+    wbuf_last += transfer(written);
+    wbuf_done[(wbuf_head + wbuf_count) % write_buffer] = wbuf_last;
+    wbuf_count++;
+  }
+
+  stat->cycles += cycles;
+  stat->words += fetched + written;
+  stat->window_words += fetched + written;
+  cycle += cycles;
+
+  if (cycle >= window_end)
+  { /* close the bandwidth window */
+    if (timing_stat_inst.window_words > timing_stat_inst.peak_words)
+      timing_stat_inst.peak_words = timing_stat_inst.window_words;
+    if (timing_stat_data.window_words > timing_stat_data.peak_words)
+      timing_stat_data.peak_words = timing_stat_data.window_words;
+    timing_stat_inst.window_words = 0;
+    timing_stat_data.window_words = 0;
+    window_end = (cycle / TIMING_WINDOW + 1) * TIMING_WINDOW;
+  }
+}
+/************************************************************/
+
+/************************************************************/
+/* words written back by the final flush, after the last reference */
+void timing_flush(int inst, unsigned written)
+{
+  Ptiming_stat stat = inst ? &timing_stat_inst : &timing_stat_data;
+
+  if (!written)
+    return;
+  stat->words += written;
+  flush_words += written;
+  if (wbuf_last < cycle)
+    wbuf_last = cycle;
+  wbuf_last += transfer(written);
+}
+/************************************************************/
+
+/************************************************************/
+void dump_timing_settings()
+{
+  printf("  Hit latency: \t%d\n", hit_latency);
+  printf("  Miss penalty: \t%d\n", miss_penalty);
+  printf("  Memory bandwidth: \t%d bytes/cycle\n", mem_bandwidth);
+  printf("  Write buffer: \t%d entries\n", write_buffer);
+}
+/************************************************************/
+
+/************************************************************/
+static void report_stream(const char *name, Ptiming_stat stat, int accesses)
+{
+  unsigned long long peak = stat->peak_words;
+
+  /* the last window may not have closed yet */
+  if (stat->window_words > peak)
+    peak = stat->window_words;
+
+  printf(" %s\n", name);
+  if (!accesses)
+    printf("  AMAT:          0\n");
+  else
+    printf("  AMAT:          %2.4f cycles\n", (double)stat->cycles / accesses);
+  printf("  cycles:        %llu\n", stat->cycles);
+  printf("  miss stalls:   %llu\n", stat->miss_stalls);
+  printf("  buffer stalls: %llu\n", stat->buffer_stalls);
+  printf("  peak bandwidth: %2.4f bytes/cycle\n",
+         (double)peak * WORD_SIZE / TIMING_WINDOW);
+}
+
+void timing_report(int inst_accesses, int data_accesses)
+{
+  unsigned long long drain = 0, end;
+
+  /* the run ends once the flush has drained from the write buffer */
+  if (flush_words && wbuf_last > cycle)
+    drain = wbuf_last - cycle;
+  end = cycle + drain;
+
+  printf("\n*** TIMING ESTIMATES ***\n");
+  report_stream("INSTRUCTIONS", &timing_stat_inst, inst_accesses);
+  report_stream("DATA", &timing_stat_data, data_accesses);
+  printf(" TOTAL\n");
+  printf("  cycles:        %llu\n", end);
+  if (inst_accesses + data_accesses)
+    printf("  AMAT:          %2.4f cycles\n", (double)cycle / (inst_accesses + data_accesses));
+  printf("  flush:         %llu words, %llu cycles\n", flush_words, drain);
+  if (end)
+    printf("  bandwidth:     %2.4f bytes/cycle\n",
+           (double)(timing_stat_inst.words + timing_stat_data.words) * WORD_SIZE / end);
+}
+/************************************************************/
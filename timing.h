@@ -0,0 +1,38 @@
+/*
+ * timing.h
+ */
+
+
+/* default timing parameters--can be changed */
+#define DEFAULT_HIT_LATENCY 1		/* cycles per reference */
+#define DEFAULT_MISS_PENALTY 100	/* cycles of memory latency per fetch */
+#define DEFAULT_MEM_BANDWIDTH 16	/* bytes per cycle to and from memory */
+#define DEFAULT_WRITE_BUFFER 8		/* outstanding writes to memory */
+#define MAX_WRITE_BUFFER 1024
+#define TIMING_WINDOW 1024		/* cycles over which peak bandwidth is taken */
+
+/* constants for settting timing parameters */
+#define TIMING_PARAM_HIT_LATENCY 0
+#define TIMING_PARAM_MISS_PENALTY 1
+#define TIMING_PARAM_MEM_BANDWIDTH 2
+#define TIMING_PARAM_WRITE_BUFFER 3
+
+
+/* structure definitions */
+typedef struct timing_stat_ {
+  unsigned long long cycles;		/* cycles spent on the stream's references */
+  unsigned long long miss_stalls;	/* cycles waiting for demand fetches */
+  unsigned long long buffer_stalls;	/* cycles waiting for a write buffer entry */
+  unsigned long long words;		/* words moved to or from memory */
+  unsigned long long window_words;	/* words moved in the current window */
+  unsigned long long peak_words;	/* most words moved in one window */
+} timing_stat, *Ptiming_stat;
+
+
+/* function prototypes */
+void set_timing_param();
+void init_timing();
+void timing_access(int inst, unsigned fetched, unsigned written);
+void timing_flush(int inst, unsigned written);
+void dump_timing_settings();
+void timing_report(int inst_accesses, int data_accesses);
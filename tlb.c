@@ -0,0 +1,202 @@
+/*
+ * tlb.c
+ *
+ * Translation model fed from the same reference stream as the caches:
+ * an instruction and a data L1 TLB backed by a shared second-level STLB.
+ * A reference that misses in its L1 TLB looks up the STLB, and one that
+ * misses there too is a page walk; translations are filled into every
+ * level they missed in, with LRU replacement within a set.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "cache.h"
+#include "main.h"
+#include "tlb.h"
+
+/* TLB configuration parameters */
+static int page_size = DEFAULT_PAGE_SIZE;
+static int itlb_entries = DEFAULT_ITLB_ENTRIES;
+static int dtlb_entries = DEFAULT_DTLB_ENTRIES;
+static int stlb_entries = DEFAULT_STLB_ENTRIES;
+static int l1_assoc = 0;	/* 0 for the per-TLB default */
+static int stlb_assoc = DEFAULT_STLB_ASSOC;
+
+/* TLB model data structures */
+static int page_offset;
+static tlb itlb;
+static tlb dtlb;
+static tlb stlb;
+static int walks_inst;
+static int walks_data;
+
+/************************************************************/
+void set_tlb_param(param, value)
+  int param;
+  int value;
+{
+  switch (param)
+  {
+  case TLB_PARAM_PAGE_SIZE:
+    if (value < MIN_PAGE_SIZE || value > MAX_PAGE_SIZE || (value & (value - 1)))
+    {
+      printf("error set_tlb_param: page size must be a power of two from %d to %d\n",
+             MIN_PAGE_SIZE, MAX_PAGE_SIZE);
+      exit(-1);
+    }
+    page_size = value;
+    break;
+  case TLB_PARAM_ITLB_ENTRIES:
+    itlb_entries = value;
+    break;
+  case TLB_PARAM_DTLB_ENTRIES:
+    dtlb_entries = value;
+    break;
+  case TLB_PARAM_STLB_ENTRIES:
+    stlb_entries = value;
+    break;
+  case TLB_PARAM_L1_ASSOC:
+    l1_assoc = value;
+    break;
+  case TLB_PARAM_STLB_ASSOC:
+    stlb_assoc = value;
+    break;
+  default:
+    printf("error set_tlb_param: bad parameter value\n");
+    exit(-1);
+  }
+}
+/************************************************************/
+
+/************************************************************/
+static void init_one(Ptlb t, int entries, int assoc, const char *name)
+{
+  memset(t, 0, sizeof(tlb));
+  if (entries == 0)
+    return;
+  if (assoc < 1 || entries < assoc || entries % assoc)
+  {
+    printf("error init_tlb: %s entries must be a multiple of its associativity\n", name);
+    exit(-1);
+  }
+  t->entries = entries;
+  t->associativity = assoc;
+  t->n_sets = entries / assoc;
+  t->vpns = (unsigned *)calloc(entries, sizeof(unsigned));
+  t->valid = (unsigned char *)calloc(entries, sizeof(unsigned char));
+  if (t->vpns == NULL || t->valid == NULL)
+  {
+    printf("error init_tlb: out of memory\n");
+    exit(-1);
+  }
+}
+
+void init_tlb()
+{
+  page_offset = (int)LOG2(page_size);
+  init_one(&itlb, itlb_entries, l1_assoc ? l1_assoc : DEFAULT_ITLB_ASSOC, "ITLB");
+  init_one(&dtlb, dtlb_entries, l1_assoc ? l1_assoc : DEFAULT_DTLB_ASSOC, "DTLB");
+  init_one(&stlb, stlb_entries, stlb_assoc, "STLB");
+  walks_inst = 0;
+  walks_data = 0;
+}
+/************************************************************/
+
+/************************************************************/
+/* looks vpn up in t and makes it MRU, filling it in on a miss */
+static int lookup(Ptlb t, unsigned vpn)
+{
+  unsigned set = (t->n_sets & (t->n_sets - 1)) ? vpn % t->n_sets : vpn & (t->n_sets - 1);
+  unsigned *vpns = t->vpns + (size_t)set * t->associativity;
+  unsigned char *valid = t->valid + (size_t)set * t->associativity;
+  int way, hit;
+
+  t->accesses++;
+  for (way = 0; way < t->associativity && valid[way]; way++)
+    if (vpns[way] == vpn)
+      break;
+  hit = (way < t->associativity && valid[way]);
+  if (!hit)
+  {
+    t->misses++;
+    if (way == t->associativity)
+      way--; /* replace the LRU entry */
+  }
+  memmove(vpns + 1, vpns, way * sizeof(unsigned));
+  memmove(valid + 1, valid, way);
+  vpns[0] = vpn;
+  valid[0] = 1;
+  return hit;
+}
+/************************************************************/
+
+/************************************************************/
+void tlb_access(unsigned addr, unsigned access_type)
+{
+  Ptlb l1 = (access_type == TRACE_INST_LOAD) ? &itlb : &dtlb;
+  unsigned vpn = addr >> page_offset;
+
+  if (l1->entries && lookup(l1, vpn))
+    return;
+  if (stlb.entries && lookup(&stlb, vpn))
+    return;
+  if (access_type == TRACE_INST_LOAD)
+    walks_inst++;
+  else
+    walks_data++;
+}
+/************************************************************/
+
+/************************************************************/
+/* one TLB level, for both the settings and the statistics */
+static void dump_one(const char *name, int entries, int assoc)
+{
+  if (entries)
+    printf("  %s: \t%d entries, %d-way\n", name, entries, assoc);
+  else
+    printf("  %s: \tnone\n", name);
+}
+
+void dump_tlb_settings()
+{
+  printf("  Page size: \t%d\n", page_size);
+  dump_one("ITLB", itlb_entries, l1_assoc ? l1_assoc : DEFAULT_ITLB_ASSOC);
+  dump_one("DTLB", dtlb_entries, l1_assoc ? l1_assoc : DEFAULT_DTLB_ASSOC);
+  dump_one("STLB", stlb_entries, stlb_assoc);
+}
+/************************************************************/
+
+/************************************************************/
+static void print_one(Ptlb t, const char *name)
+{
+  printf(" %s\n", name);
+  printf("  accesses:  %d\n", t->accesses);
+  printf("  misses:    %d\n", t->misses);
+  if (!t->accesses)
+    printf("  miss rate: 0 (0)\n");
+  else
+    printf("  miss rate: %2.4f (hit rate %2.4f)\n",
+           (float)t->misses / (float)t->accesses,
+           1.0 - (float)t->misses / (float)t->accesses);
+}
+
+void print_tlb_stats()
+{
+  printf("\n*** TLB STATISTICS ***\n");
+  dump_one("ITLB", itlb.entries, itlb.associativity);
+  dump_one("DTLB", dtlb.entries, dtlb.associativity);
+  dump_one("STLB", stlb.entries, stlb.associativity);
+  if (itlb.entries)
+    print_one(&itlb, "ITLB");
+  if (dtlb.entries)
+    print_one(&dtlb, "DTLB");
+  if (stlb.entries)
+    print_one(&stlb, "STLB");
+  printf(" PAGE WALKS\n");
+  printf("  instructions: %d\n", walks_inst);
+  printf("  data:         %d\n", walks_data);
+}
+/************************************************************/
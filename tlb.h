@@ -0,0 +1,43 @@
+/*
+ * tlb.h
+ */
+
+
+/* default TLB parameters--can be changed */
+#define DEFAULT_PAGE_SIZE 4096
+#define DEFAULT_ITLB_ENTRIES 128
+#define DEFAULT_ITLB_ASSOC 8
+#define DEFAULT_DTLB_ENTRIES 64
+#define DEFAULT_DTLB_ASSOC 4
+#define DEFAULT_STLB_ENTRIES 1536
+#define DEFAULT_STLB_ASSOC 12
+#define MIN_PAGE_SIZE 4096
+#define MAX_PAGE_SIZE (1024 * 1024 * 1024)
+
+/* constants for settting TLB parameters */
+#define TLB_PARAM_PAGE_SIZE 0
+#define TLB_PARAM_ITLB_ENTRIES 1
+#define TLB_PARAM_DTLB_ENTRIES 2
+#define TLB_PARAM_STLB_ENTRIES 3
+#define TLB_PARAM_L1_ASSOC 4
+#define TLB_PARAM_STLB_ASSOC 5
+
+
+/* structure definitions */
+typedef struct tlb_ {
+  int entries;			/* number of translations held */
+  int associativity;		/* TLB associativity */
+  int n_sets;			/* number of TLB sets */
+  unsigned *vpns;		/* virtual page of each entry, sets MRU first */
+  unsigned char *valid;		/* whether each entry holds a translation */
+  int accesses;			/* number of lookups */
+  int misses;			/* number of lookups that missed */
+} tlb, *Ptlb;
+
+
+/* function prototypes */
+void set_tlb_param();
+void init_tlb();
+void tlb_access(unsigned addr, unsigned access_type);
+void dump_tlb_settings();
+void print_tlb_stats();
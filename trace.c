@@ -0,0 +1,461 @@
+/*
+ * trace.c
+ *
+ * Parallel reader for text traces.  The trace is mapped, cut into chunks
+ * that end on line boundaries, and each chunk of a window is decoded by
+ * its own thread into a record buffer.  The simulator takes the buffers
+ * in trace order, and while it replays one window the threads decode the
+ * next one.
+ *
+ * It also keeps the sidecar index of a trace (<trace>.idx): the byte
+ * offset of every interval-th record and the records of each interval by
+ * access type, so that a record range can be replayed without scanning
+ * what comes before it.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "cache.h"
+#include "main.h"
+#include "trace.h"
+
+static const char *map;		/* the mapped trace */
+static size_t map_size;
+static size_t next_offset;	/* first byte not yet handed to a chunk */
+static int n_threads;
+static parse_chunk chunks[2][MAX_PARSE_THREADS];	/* two windows */
+static pthread_t threads[2][MAX_PARSE_THREADS];
+static int launched[2];		/* chunks being decoded in each window */
+static int current;		/* window being replayed */
+static int consumed;		/* chunks of it handed out so far */
+
+/************************************************************/
+int default_parse_threads()
+{
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+  if (n < 1)
+    return 1;
+  return n > MAX_PARSE_THREADS ? MAX_PARSE_THREADS : (int)n;
+}
+/************************************************************/
+
+/************************************************************/
+/*
+ * decodes "<type> <hex address>" lines from *text up to end, ignoring
+ * anything after the address, blank lines and lines that do not start
+ * with both fields; stops when out is full and leaves *text at the first
+ * line not decoded
+ */
+long parse_text(const char **text, const char *end, Ptrace_record out, long capacity)
+{
+  const char *p = *text;
+  long n = 0;
+
+  while (p < end && n < capacity)
+  {
+    unsigned type = 0, addr = 0;
+    const char *start;
+
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' ||
+                       *p == '\v' || *p == '\f'))
+      p++;
+    if (p == end)
+      break;
+
+    start = p;
+    while (p < end && *p >= '0' && *p <= '9')
+      type = type * 10 + (*p++ - '0');
+    if (p == start)
+      goto next_line;
+
+    while (p < end && (*p == ' ' || *p == '\t'))
+      p++;
+    if (end - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+      p += 2;
+    start = p;
+    for (; p < end; p++)
+    {
+      unsigned d;
+      if (*p >= '0' && *p <= '9')
+        d = *p - '0';
+      else if (*p >= 'a' && *p <= 'f')
+        d = *p - 'a' + 10;
+      else if (*p >= 'A' && *p <= 'F')
+        d = *p - 'A' + 10;
+      else
+        break;
+      addr = (addr << 4) | d;
+    }
+    if (p == start)
+      goto next_line;
+
+    out[n].access_type = type;
+    out[n].addr = addr;
+    n++;
+
+  next_line:
+    p = memchr(p, '\n', end - p);
+    p = (p == NULL) ? end : p + 1;
+  }
+
+  *text = p;
+  return n;
+}
+/************************************************************/
+
+/************************************************************/
+static void *parse_worker(void *arg)
+{
+  Pparse_chunk c = (Pparse_chunk)arg;
+  const char *p = c->begin;
+
+  c->count = 0;
+  c->failed = FALSE;
+  for (;;)
+  {
+    Ptrace_record grown;
+
+    c->count += parse_text(&p, c->end, c->records + c->count, c->capacity - c->count);
+    if (p >= c->end)
+      return NULL;
+
+    /* the buffer filled up before the chunk did */
+    grown = (Ptrace_record)realloc(c->records, sizeof(trace_record) * c->capacity * 2);
+    if (grown == NULL)
+    {
+      c->failed = TRUE;
+      return NULL;
+    }
+    c->records = grown;
+    c->capacity *= 2;
+  }
+}
+/************************************************************/
+
+/************************************************************/
+/* cuts the next chunks of the trace and starts decoding them */
+static void launch_window(int w)
+{
+  launched[w] = 0;
+  while (launched[w] < n_threads && next_offset < map_size)
+  {
+    Pparse_chunk c = &chunks[w][launched[w]];
+    const char *end = map + map_size;
+
+    c->begin = map + next_offset;
+    c->end = (map_size - next_offset > PARSE_CHUNK_SIZE) ? c->begin + PARSE_CHUNK_SIZE : end;
+    if (c->end < end)
+    { /* stop after the line the cut falls in */
+      const char *nl = memchr(c->end, '\n', end - c->end);
+      c->end = (nl == NULL) ? end : nl + 1;
+    }
+    next_offset = c->end - map;
+
+    if (c->records == NULL)
+    {
+      c->capacity = PARSE_CHUNK_SIZE / 8;
+      c->records = (Ptrace_record)malloc(sizeof(trace_record) * c->capacity);
+      if (c->records == NULL)
+      {
+        printf("error trace_map: out of memory\n");
+        exit(-1);
+      }
+    }
+    if (pthread_create(&threads[w][launched[w]], NULL, parse_worker, c) != 0)
+    {
+      printf("error trace_map: cannot start parsing thread\n");
+      exit(-1);
+    }
+    launched[w]++;
+  }
+}
+
+static void join_window(int w)
+{
+  for (int i = 0; i < launched[w]; i++)
+  {
+    pthread_join(threads[w][i], NULL);
+    if (chunks[w][i].failed)
+    {
+      printf("error trace_map: out of memory\n");
+      exit(-1);
+    }
+  }
+}
+/************************************************************/
+
+/************************************************************/
+/*
+ * maps a text trace for parallel decoding from byte offset on, FALSE if it
+ * cannot be mapped
+ */
+int trace_map(FILE *f, int threads, unsigned long long offset)
+{
+  struct stat st;
+  void *p;
+
+  if (fstat(fileno(f), &st) != 0 || !S_ISREG(st.st_mode) ||
+      (unsigned long long)st.st_size <= offset)
+    return FALSE;
+  p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+  if (p == MAP_FAILED)
+    return FALSE;
+  madvise(p, st.st_size, MADV_SEQUENTIAL);
+
+  map = (const char *)p;
+  map_size = st.st_size;
+  next_offset = offset;
+  n_threads = (threads < 1) ? 1 : (threads > MAX_PARSE_THREADS ? MAX_PARSE_THREADS : threads);
+  current = 0;
+  consumed = 0;
+  launch_window(0);
+  join_window(0);
+  launch_window(1);
+  return TRUE;
+}
+/************************************************************/
+
+/************************************************************/
+/* hands out the next decoded chunk in trace order, FALSE at the end */
+int trace_next_batch(Ptrace_record *records, long *n)
+{
+  Pparse_chunk c;
+
+  if (consumed == launched[current])
+  { /* this window is replayed, move on to the one being decoded */
+    int next = 1 - current;
+    join_window(next);
+    if (launched[next] == 0)
+      return FALSE;
+    current = next;
+    consumed = 0;
+    launch_window(1 - current);
+  }
+
+  c = &chunks[current][consumed++];
+  *records = c->records;
+  *n = c->count;
+  return TRUE;
+}
+/************************************************************/
+
+/************************************************************/
+void trace_unmap()
+{
+  join_window(1 - current);
+  munmap((void *)map, map_size);
+  for (int w = 0; w < 2; w++)
+    for (int i = 0; i < MAX_PARSE_THREADS; i++)
+    {
+      free(chunks[w][i].records);
+      chunks[w][i].records = NULL;
+    }
+  map = NULL;
+}
+/************************************************************/
+
+/************************************************************/
+/* adds one record to the last index entry, opening a new one every interval */
+static void index_record(Ptrace_index idx, unsigned long long *capacity,
+                         unsigned type, unsigned long long offset)
+{
+  Ptrace_index_entry e;
+
+  if (idx->n_records % idx->interval == 0)
+  {
+    if (idx->n_segments == *capacity)
+    {
+      *capacity = *capacity ? 2 * *capacity : 1024;
+      idx->entries = (Ptrace_index_entry)realloc(idx->entries,
+                                                 sizeof(trace_index_entry) * *capacity);
+      if (idx->entries == NULL)
+      {
+        printf("error trace_load_index: out of memory\n");
+        exit(-1);
+      }
+    }
+    e = &idx->entries[idx->n_segments++];
+    memset(e, 0, sizeof(trace_index_entry));
+    e->offset = offset;
+  }
+  e = &idx->entries[idx->n_segments - 1];
+  e->counts[type < TRACE_INDEX_N_COUNTS - 1 ? type : TRACE_INDEX_N_COUNTS - 1]++;
+  idx->n_records++;
+}
+/************************************************************/
+
+/************************************************************/
+/* scans the whole trace once */
+static void build_index(Ptrace_index idx, FILE *f, int binary)
+{
+  const char *data, *p, *end;
+  unsigned long long capacity = 0;
+  void *m;
+
+  m = mmap(NULL, idx->trace_size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+  if (m == MAP_FAILED)
+  {
+    printf("error trace_load_index: cannot map the trace\n");
+    exit(-1);
+  }
+  madvise(m, idx->trace_size, MADV_SEQUENTIAL);
+  data = (const char *)m;
+  end = data + idx->trace_size;
+
+  if (binary)
+  {
+    Ptrace_record r = (Ptrace_record)(data + TRACE_BINARY_MAGIC_SIZE);
+    unsigned long long n = (idx->trace_size - TRACE_BINARY_MAGIC_SIZE) / sizeof(trace_record);
+    for (unsigned long long i = 0; i < n; i++)
+      index_record(idx, &capacity, r[i].access_type,
+                   TRACE_BINARY_MAGIC_SIZE + i * sizeof(trace_record));
+  }
+  else
+    for (p = data; p < end;)
+    {
+      /* a record's offset is where the scan for it starts */
+      const char *line = p;
+      trace_record r;
+      if (parse_text(&p, end, &r, 1) == 1)
+        index_record(idx, &capacity, r.access_type, line - data);
+    }
+
+  munmap(m, idx->trace_size);
+}
+/************************************************************/
+
+/************************************************************/
+/*
+ * returns the index of the trace at path, reading <path>.idx when it
+ * matches the trace and interval (0 takes any) and otherwise building it
+ * and writing it back
+ */
+Ptrace_index trace_load_index(FILE *f, const char *path, int binary,
+                              unsigned long long interval)
+{
+  char name[4096];
+  struct stat st;
+  Ptrace_index idx;
+  FILE *idx_file;
+
+  if (fstat(fileno(f), &st) != 0 || !S_ISREG(st.st_mode))
+  {
+    printf("error trace_load_index: %s is not a regular file\n", path);
+    exit(-1);
+  }
+  snprintf(name, sizeof(name), "%s%s", path, TRACE_INDEX_SUFFIX);
+
+  idx = (Ptrace_index)calloc(1, sizeof(trace_index));
+  if (idx == NULL)
+  {
+    printf("error trace_load_index: out of memory\n");
+    exit(-1);
+  }
+
+  idx_file = fopen(name, "rb");
+  if (idx_file != NULL)
+  {
+    if (fread(idx, offsetof(trace_index, entries), 1, idx_file) == 1 &&
+        !memcmp(idx->magic, TRACE_INDEX_MAGIC, TRACE_INDEX_MAGIC_SIZE) &&
+        idx->trace_size == (unsigned long long)st.st_size &&
+        idx->trace_mtime == (long long)st.st_mtime &&
+        (interval == 0 || idx->interval == interval))
+    {
+      idx->entries = (Ptrace_index_entry)malloc(sizeof(trace_index_entry) *
+                                                (idx->n_segments ? idx->n_segments : 1));
+      if (idx->entries != NULL &&
+          fread(idx->entries, sizeof(trace_index_entry), idx->n_segments, idx_file) ==
+          idx->n_segments)
+      {
+        fclose(idx_file);
+        return idx;
+      }
+      free(idx->entries);
+    }
+    fclose(idx_file);
+  }
+
+  /* missing or stale */
+  memset(idx, 0, sizeof(trace_index));
+  memcpy(idx->magic, TRACE_INDEX_MAGIC, TRACE_INDEX_MAGIC_SIZE);
+  idx->trace_size = st.st_size;
+  idx->trace_mtime = st.st_mtime;
+  idx->interval = interval ? interval : DEFAULT_INDEX_INTERVAL;
+  printf("building trace index %s\n", name);
+  if (idx->trace_size > (binary ? TRACE_BINARY_MAGIC_SIZE : 0))
+    build_index(idx, f, binary);
+
+  idx_file = fopen(name, "wb");
+  if (idx_file == NULL ||
+      fwrite(idx, offsetof(trace_index, entries), 1, idx_file) != 1 ||
+      fwrite(idx->entries, sizeof(trace_index_entry), idx->n_segments, idx_file) !=
+      idx->n_segments)
+    printf("warning: cannot write trace index %s\n", name);
+  if (idx_file != NULL)
+    fclose(idx_file);
+  return idx;
+}
+/************************************************************/
+
+/************************************************************/
+/*
+ * positions f at the start of the index segment holding record, which is
+ * also left in *offset, returns the records to skip from there
+ */
+unsigned long long trace_seek(FILE *f, Ptrace_index idx, unsigned long long record,
+                              unsigned long long *offset)
+{
+  unsigned long long s = record / idx->interval;
+
+  if (s >= idx->n_segments)
+  {
+    printf("error trace_seek: record %llu is past the end of the trace\n", record);
+    exit(-1);
+  }
+  *offset = idx->entries[s].offset;
+  if (fseeko(f, *offset, SEEK_SET) != 0)
+  {
+    printf("error trace_seek: cannot seek in the trace\n");
+    exit(-1);
+  }
+  return record - s * idx->interval;
+}
+/************************************************************/
+
+/************************************************************/
+void dump_trace_index(Ptrace_index idx)
+{
+  unsigned long long counts[TRACE_INDEX_N_COUNTS] = {0};
+
+  for (unsigned long long s = 0; s < idx->n_segments; s++)
+    for (int t = 0; t < TRACE_INDEX_N_COUNTS; t++)
+      counts[t] += idx->entries[s].counts[t];
+
+  printf("  Trace records: \t%llu\n", idx->n_records);
+  printf("  Index interval: \t%llu (%llu segments)\n", idx->interval, idx->n_segments);
+  printf("  Data loads: \t%llu\n", counts[TRACE_DATA_LOAD]);
+  printf("  Data stores: \t%llu\n", counts[TRACE_DATA_STORE]);
+  printf("  Inst loads: \t%llu\n", counts[TRACE_INST_LOAD]);
+  printf("  Unknown type: \t%llu\n", counts[TRACE_INDEX_N_COUNTS - 1]);
+}
+/************************************************************/
+
+/************************************************************/
+void trace_free_index(Ptrace_index idx)
+{
+  if (idx == NULL)
+    return;
+  free(idx->entries);
+  free(idx);
+}
+/************************************************************/
@@ -0,0 +1,55 @@
+/*
+ * trace.h
+ */
+
+
+/* parallel text trace reader parameters--can be changed */
+#define PARSE_CHUNK_SIZE (1024 * 1024)	/* bytes of trace per parsing task */
+#define MAX_PARSE_THREADS 64
+
+/* trace index parameters--can be changed */
+#define TRACE_INDEX_SUFFIX ".idx"
+#define TRACE_INDEX_MAGIC "CSIMIDX1"
+#define TRACE_INDEX_MAGIC_SIZE 8
+#define DEFAULT_INDEX_INTERVAL 1000000	/* records per index segment */
+#define TRACE_INDEX_N_COUNTS 4		/* data loads, stores, fetches, unknown */
+
+
+/* structure definitions */
+typedef struct parse_chunk_ {
+  const char *begin;		/* first byte of the chunk's lines */
+  const char *end;		/* one past the last byte */
+  Ptrace_record records;	/* decoded references, in trace order */
+  long capacity;		/* records the buffer can hold */
+  long count;			/* records decoded */
+  int failed;			/* out of memory while decoding */
+} parse_chunk, *Pparse_chunk;
+
+typedef struct trace_index_entry_ {
+  unsigned long long offset;	/* byte offset of the segment's first record */
+  unsigned long long counts[TRACE_INDEX_N_COUNTS];	/* records by access type */
+} trace_index_entry, *Ptrace_index_entry;
+
+typedef struct trace_index_ {
+  char magic[TRACE_INDEX_MAGIC_SIZE];
+  unsigned long long trace_size;	/* of the trace it was built from */
+  long long trace_mtime;
+  unsigned long long n_records;
+  unsigned long long interval;	/* records per segment */
+  unsigned long long n_segments;
+  Ptrace_index_entry entries;	/* not stored, entries follow the header */
+} trace_index, *Ptrace_index;
+
+
+/* function prototypes */
+int default_parse_threads();
+int trace_map(FILE *f, int n_threads, unsigned long long offset);
+int trace_next_batch(Ptrace_record *records, long *n);
+void trace_unmap();
+long parse_text(const char **text, const char *end, Ptrace_record out, long capacity);
+Ptrace_index trace_load_index(FILE *f, const char *path, int binary,
+                              unsigned long long interval);
+unsigned long long trace_seek(FILE *f, Ptrace_index idx, unsigned long long record,
+                              unsigned long long *offset);
+void dump_trace_index(Ptrace_index idx);
+void trace_free_index(Ptrace_index idx);
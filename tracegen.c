@@ -0,0 +1,84 @@
+/*
+ * tracegen.c
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "gen.h"
+
+/************************************************************/
+static void usage()
+{
+  printf("usage:  tracegen <options> <pattern>\n");
+  printf("\t-h:  \t\tthis message\n\n");
+  printf("\t-n <n>: \tnumber of references to generate\n");
+  printf("\t-f <f>: \tdata footprint in bytes\n");
+  printf("\t-s <s>: \tstride in bytes for the stride pattern\n");
+  printf("\t-seed <seed>: \tgenerator seed\n");
+  printf("\tpatterns: \tseq stride random chase zipf mixed\n");
+}
+/************************************************************/
+
+/************************************************************/
+int main(int argc, char **argv)
+{
+  unsigned long long n_refs = 1000000;
+  unsigned footprint = GEN_DEFAULT_FOOTPRINT;
+  unsigned stride = GEN_DEFAULT_STRIDE;
+  unsigned long long seed = GEN_DEFAULT_SEED;
+  int arg_index, pattern;
+  unsigned access_type, addr;
+  gen_state g;
+
+  for (arg_index = 1; arg_index < argc; arg_index++)
+    if (!strcmp(argv[arg_index], "-h"))
+    {
+      usage();
+      exit(0);
+    }
+
+  if (argc < 2)
+  {
+    usage();
+    exit(-1);
+  }
+
+  arg_index = 1;
+  while (arg_index < argc - 1)
+  {
+    if (!strcmp(argv[arg_index], "-n"))
+      n_refs = strtoull(argv[arg_index + 1], NULL, 0);
+    else if (!strcmp(argv[arg_index], "-f"))
+      footprint = (unsigned)strtoul(argv[arg_index + 1], NULL, 0);
+    else if (!strcmp(argv[arg_index], "-s"))
+      stride = (unsigned)strtoul(argv[arg_index + 1], NULL, 0);
+    else if (!strcmp(argv[arg_index], "-seed"))
+      seed = strtoull(argv[arg_index + 1], NULL, 0);
+    else
+    {
+      printf("error:  unrecognized flag %s\n", argv[arg_index]);
+      exit(-1);
+    }
+    arg_index += 2;
+  }
+
+  pattern = gen_pattern_by_name(argv[argc - 1]);
+  if (pattern < 0 || arg_index != argc - 1)
+  {
+    printf("error:  unknown pattern %s\n", argv[argc - 1]);
+    exit(-1);
+  }
+
+  gen_init(&g, pattern, footprint, stride, seed);
+  for (unsigned long long i = 0; i < n_refs; i++)
+  {
+    gen_next(&g, &access_type, &addr);
+    printf("%u %x\n", access_type, addr);
+  }
+  gen_free(&g);
+
+  return 0;
+}
+/************************************************************/
@@ -0,0 +1,439 @@
+/*
+ * verify.c
+ *
+ * Differential verifier: replays generated and random traces through the
+ * reference model (refcache.c) and the simulator engine (cache.c) side by
+ * side, comparing the statistics after every reference and the cache
+ * contents after every batch.  A divergence is shrunk to a minimal trace
+ * that is written to VERIFY_FAIL_TRACE.  The configurations of the
+ * kernels in CACHE_KERNELS are checked too, so each specialized kernel
+ * is run against the reference model.
+ *
+ * The reference model has no victim cache.  With one, accesses, misses,
+ * replacements and the tags in LRU order must still match, since the
+ * victim cache only changes where evicted lines go.  Dirty bits and
+ * traffic are not compared.  Instead, no block may be both in the cache
+ * and in its victim cache, and in a unified no-write-allocate cache a
+ * store that misses must leave no copy of its block in the victim cache.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cache.h"
+#include "main.h"
+#include "gen.h"
+#include "refcache.h"
+
+#define VERIFY_DEFAULT_REFS 200000
+#define VERIFY_DEFAULT_BATCH 4096
+#define VERIFY_FAIL_TRACE "verify_fail.trace"
+#define VERIFY_UNIFORM GEN_N_PATTERNS	/* uniformly random types and addresses */
+
+/* configurations checked, as simulator flags */
+static const char *configs[] = {
+  "-us 8192 -bs 16 -a 1 -wb -wa",
+  "-us 8192 -bs 16 -a 1 -wt -nw",
+  "-us 8192 -bs 16 -a 1 -wt -wa",
+  "-us 8192 -bs 16 -a 1 -wb -nw",
+  "-us 16384 -bs 32 -a 2 -wb -wa",
+  "-us 16384 -bs 32 -a 4 -wt -wa",
+  "-us 32768 -bs 64 -a 8 -wb -nw",
+  "-us 4096 -bs 16 -a 256 -wb -wa",
+  "-is 8192 -ds 8192 -bs 16 -a 1 -wb -wa",
+  "-is 8192 -ds 8192 -bs 16 -a 1 -wt -nw",
+  "-is 16384 -ds 32768 -bs 32 -a 4 -wb -nw",
+  "-is 32768 -ds 32768 -bs 64 -a 8 -wt -wa",
+  "-us 262144 -bs 128 -a 64 -wt -wa",
+  "-us 1048576 -bs 64 -a 16 -wb -wa",
+  "-us 8192 -bs 16 -a 1 -wb -nw -vc 4",
+  "-us 8192 -bs 16 -a 1 -wt -nw -vc 4",
+  "-us 16384 -bs 32 -a 2 -wb -wa -vc 8",
+  "-is 8192 -ds 8192 -bs 16 -a 1 -wb -nw -vc 4",
+  "-is 8192 -ds 8192 -bs 32 -a 2 -wt -wa -vc 16",
+};
+#define N_CONFIGS ((int)(sizeof(configs) / sizeof(configs[0])))
+
+#ifdef CACHE_KERNELS
+static const cache_kernel_entry kernels[] = {
+#define KERNEL(name, split, isize, dsize, bs, assoc, wb, wa) \
+  {#name, split, isize, dsize, bs, assoc, wb, wa, NULL},
+#include CACHE_KERNELS
+#undef KERNEL
+};
+#define N_KERNELS ((int)(sizeof(kernels) / sizeof(kernels[0])))
+#else
+#define N_KERNELS 0
+#endif
+
+static const char *config;	/* configuration being checked */
+static int max_assoc;
+static int victim;		/* victim cache lines of the configuration */
+static int block_size;
+static int split;
+static int writealloc;
+static unsigned *tags_opt, *tags_ref;
+static int *dirty_opt, *dirty_ref;
+static unsigned victim_blocks[MAX_CACHE_VICTIM];
+static int victim_dirty[MAX_CACHE_VICTIM];
+
+/************************************************************/
+/*
+ * applies a flag string to one model, returns the total cache size; the
+ * reference model gets no victim cache
+ */
+static int apply_config(const char *flags, void (*set)())
+{
+  char buf[256];
+  int total = 0;
+  char *tok;
+
+  victim = 0;
+  block_size = DEFAULT_CACHE_BLOCK_SIZE;
+  split = FALSE;
+  writealloc = DEFAULT_CACHE_WRITEALLOC;
+  if (set == set_cache_param)
+    set(CACHE_PARAM_VICTIM, 0);
+  strncpy(buf, flags, sizeof(buf) - 1);
+  buf[sizeof(buf) - 1] = '\0';
+  for (tok = strtok(buf, " "); tok != NULL; tok = strtok(NULL, " "))
+  {
+    if (!strcmp(tok, "-wb"))
+      set(CACHE_PARAM_WRITEBACK, 0);
+    else if (!strcmp(tok, "-wt"))
+      set(CACHE_PARAM_WRITETHROUGH, 0);
+    else if (!strcmp(tok, "-wa"))
+    {
+      set(CACHE_PARAM_WRITEALLOC, 0);
+      writealloc = TRUE;
+    }
+    else if (!strcmp(tok, "-nw"))
+    {
+      set(CACHE_PARAM_NOWRITEALLOC, 0);
+      writealloc = FALSE;
+    }
+    else
+    {
+      int value = atoi(strtok(NULL, " "));
+      if (!strcmp(tok, "-bs"))
+      {
+        set(CACHE_PARAM_BLOCK_SIZE, value);
+        block_size = value;
+      }
+      else if (!strcmp(tok, "-us"))
+        set(CACHE_PARAM_USIZE, value);
+      else if (!strcmp(tok, "-is"))
+      {
+        set(CACHE_PARAM_ISIZE, value);
+        split = TRUE;
+      }
+      else if (!strcmp(tok, "-ds"))
+        set(CACHE_PARAM_DSIZE, value);
+      else if (!strcmp(tok, "-a"))
+      {
+        set(CACHE_PARAM_ASSOC, value);
+        max_assoc = value;
+      }
+      else if (!strcmp(tok, "-vc"))
+      {
+        if (set == set_cache_param)
+          set(CACHE_PARAM_VICTIM, value);
+        victim = value;
+        continue;
+      }
+      if (strcmp(tok, "-bs") && strcmp(tok, "-a"))
+        total += value;
+    }
+  }
+  return total;
+}
+/************************************************************/
+
+/************************************************************/
+static int same_stats()
+{
+  cache_stat oi, od, ri, rd;
+
+  get_cache_stats(&oi, &od);
+  ref_get_cache_stats(&ri, &rd);
+  if (victim)
+    return oi.accesses == ri.accesses && oi.misses == ri.misses &&
+           oi.replacements == ri.replacements && od.accesses == rd.accesses &&
+           od.misses == rd.misses && od.replacements == rd.replacements;
+  return !memcmp(&oi, &ri, sizeof(cache_stat)) && !memcmp(&od, &rd, sizeof(cache_stat));
+}
+/************************************************************/
+
+/************************************************************/
+/*
+ * compares tags, dirty bits (without a victim cache) and LRU order of
+ * every set, and checks that no victim cache line is also in its set
+ */
+static int same_contents()
+{
+  for (int which = 0; which < 2; which++)
+  {
+    int n_sets = get_n_sets(which);
+    if (n_sets != ref_get_n_sets(which))
+      return FALSE;
+    for (int set = 0; set < n_sets; set++)
+    {
+      int n = get_set_lines(which, set, tags_opt, dirty_opt);
+      if (n != ref_get_set_lines(which, set, tags_ref, dirty_ref))
+        return FALSE;
+      for (int i = 0; i < n; i++)
+        if (tags_opt[i] != tags_ref[i] ||
+            (!victim && (dirty_opt[i] != 0) != (dirty_ref[i] != 0)))
+          return FALSE;
+    }
+    if (victim && n_sets)
+    {
+      int n_victims = get_victim_lines(which, victim_blocks, victim_dirty);
+      for (int v = 0; v < n_victims; v++)
+      {
+        int n = get_set_lines(which, victim_blocks[v] % n_sets, tags_opt, dirty_opt);
+        for (int i = 0; i < n; i++)
+          if (tags_opt[i] == victim_blocks[v] / n_sets)
+            return FALSE;
+      }
+    }
+  }
+  return TRUE;
+}
+/************************************************************/
+
+/************************************************************/
+/* TRUE if the victim cache of c1 or c2 holds the block of addr */
+static int in_victim_cache(int which, unsigned addr)
+{
+  int n = get_victim_lines(which, victim_blocks, victim_dirty);
+
+  for (int v = 0; v < n; v++)
+    if (victim_blocks[v] == addr / block_size)
+      return TRUE;
+  return FALSE;
+}
+/************************************************************/
+
+/************************************************************/
+/*
+ * replays a trace through both models from a cold start, returns the
+ * index of the reference after which they first disagree (n if only the
+ * final flush disagrees), or -1 if they agree throughout
+ */
+static long replay(Ptrace_record t, long n, long batch)
+{
+  long bad = -1;
+
+  apply_config(config, set_cache_param);
+  apply_config(config, ref_set_cache_param);
+  init_cache();
+  ref_init_cache();
+
+  for (long i = 0; i < n && bad < 0; i++)
+  {
+    cache_stat before_inst, before_data, after_inst, after_data;
+
+    get_cache_stats(&before_inst, &before_data);
+    perform_access(t[i].addr, t[i].access_type);
+    ref_perform_access(t[i].addr, t[i].access_type);
+    get_cache_stats(&after_inst, &after_data);
+    if (!same_stats())
+      bad = i;
+    else if (victim && !split && !writealloc && t[i].access_type == TRACE_DATA_STORE &&
+             after_data.misses != before_data.misses && in_victim_cache(0, t[i].addr))
+      bad = i;
+    else if ((i % batch == batch - 1 || i == n - 1) && !same_contents())
+      bad = i;
+  }
+
+  if (bad < 0)
+  {
+    flush();
+    ref_flush();
+    if (!same_stats())
+      bad = n;
+  }
+
+  free_cache();
+  ref_free_cache();
+  return bad;
+}
+/************************************************************/
+
+/************************************************************/
+/* delta-debugs a failing trace down to a minimal failing one */
+static long shrink(Ptrace_record t, long n, long batch)
+{
+  Ptrace_record tmp = (Ptrace_record)malloc(sizeof(trace_record) * n);
+  long first = replay(t, n, batch);
+
+  /* nothing after the first divergence matters */
+  if (first >= 0 && first < n)
+    n = first + 1;
+
+  for (long chunk = n / 2; chunk >= 1 && n > 1;)
+  {
+    int removed = FALSE;
+    for (long start = 0; start < n && n > 1;)
+    {
+      long len = (start + chunk > n) ? n - start : chunk;
+      memcpy(tmp, t, sizeof(trace_record) * start);
+      memcpy(tmp + start, t + start + len, sizeof(trace_record) * (n - start - len));
+      if (replay(tmp, n - len, n - len) >= 0)
+      {
+        memcpy(t, tmp, sizeof(trace_record) * (n - len));
+        n -= len;
+        removed = TRUE;
+      }
+      else
+        start += len;
+    }
+    if (!removed)
+      chunk /= 2;
+    else if (chunk > n / 2)
+      chunk = n / 2;
+  }
+
+  free(tmp);
+  return n;
+}
+/************************************************************/
+
+/************************************************************/
+static void report_failure(const char *pattern, Ptrace_record t, long n, long batch)
+{
+  FILE *out;
+
+  n = shrink(t, n, batch);
+  printf("FAIL: %s on %s trace, minimal trace has %ld references:\n",
+         config, pattern, n);
+  out = fopen(VERIFY_FAIL_TRACE, "w");
+  for (long i = 0; i < n; i++)
+  {
+    printf("  %u %x\n", t[i].access_type, t[i].addr);
+    if (out != NULL)
+      fprintf(out, "%u %x\n", t[i].access_type, t[i].addr);
+  }
+  if (out != NULL)
+  {
+    fclose(out);
+    printf("reproduce with:  ./simulador %s %s\n", config, VERIFY_FAIL_TRACE);
+  }
+}
+/************************************************************/
+
+/************************************************************/
+/* the simulator flags of the i-th specialized kernel */
+static const char *kernel_config(int i)
+{
+  static char buf[256];
+
+#ifdef CACHE_KERNELS
+  const cache_kernel_entry *k = &kernels[i];
+  if (k->split)
+    snprintf(buf, sizeof(buf), "-is %d -ds %d", k->isize, k->dsize);
+  else
+    snprintf(buf, sizeof(buf), "-us %d", k->isize);
+  snprintf(buf + strlen(buf), sizeof(buf) - strlen(buf), " -bs %d -a %d %s %s",
+           k->block_size, k->assoc, k->writeback ? "-wb" : "-wt",
+           k->writealloc ? "-wa" : "-nw");
+#else
+  (void)i;
+  buf[0] = '\0';
+#endif
+  return buf;
+}
+/************************************************************/
+
+/************************************************************/
+int main(int argc, char **argv)
+{
+  long n_refs = VERIFY_DEFAULT_REFS;
+  long batch = VERIFY_DEFAULT_BATCH;
+  unsigned long long seed = GEN_DEFAULT_SEED;
+  Ptrace_record t;
+  int failures = 0;
+
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    if (!strcmp(argv[i], "-n"))
+      n_refs = atol(argv[i + 1]);
+    else if (!strcmp(argv[i], "-batch"))
+      batch = atol(argv[i + 1]);
+    else if (!strcmp(argv[i], "-seed"))
+      seed = strtoull(argv[i + 1], NULL, 0);
+    else
+    {
+      printf("usage:  verify [-n <refs>] [-batch <refs>] [-seed <seed>]\n");
+      exit(-1);
+    }
+  }
+  if (n_refs < 1 || batch < 1)
+  {
+    printf("error:  -n and -batch must be positive\n");
+    exit(-1);
+  }
+
+  t = (Ptrace_record)malloc(sizeof(trace_record) * n_refs);
+  if (t == NULL)
+  {
+    printf("error:  out of memory\n");
+    exit(-1);
+  }
+
+  for (int c = 0; c < N_CONFIGS + N_KERNELS; c++)
+  {
+    int total;
+
+    config = c < N_CONFIGS ? configs[c] : kernel_config(c - N_CONFIGS);
+    max_assoc = DEFAULT_CACHE_ASSOC;
+    total = apply_config(config, set_cache_param);
+    tags_opt = (unsigned *)malloc(sizeof(unsigned) * max_assoc);
+    tags_ref = (unsigned *)malloc(sizeof(unsigned) * max_assoc);
+    dirty_opt = (int *)malloc(sizeof(int) * max_assoc);
+    dirty_ref = (int *)malloc(sizeof(int) * max_assoc);
+
+    for (int p = 0; p <= VERIFY_UNIFORM; p++)
+    {
+      gen_state g;
+
+      /* a footprint a few times the cache gives hits, misses and conflicts */
+      gen_init(&g, p == VERIFY_UNIFORM ? GEN_RANDOM : p, 4 * total,
+               GEN_DEFAULT_STRIDE, seed + c * 131 + p);
+      for (long i = 0; i < n_refs; i++)
+      {
+        if (p == VERIFY_UNIFORM)
+        {
+          t[i].access_type = gen_random(&g, 3);
+          t[i].addr = gen_random(&g, 4 * total / WORD_SIZE) * WORD_SIZE;
+        }
+        else
+          gen_next(&g, &t[i].access_type, &t[i].addr);
+      }
+      gen_free(&g);
+
+      if (replay(t, n_refs, batch) >= 0)
+      {
+        report_failure(p == VERIFY_UNIFORM ? "uniform" : gen_pattern_name(p),
+                       t, n_refs, batch);
+        failures++;
+        break;
+      }
+    }
+
+    printf("%-40s %s (%s kernel)\n", config, failures ? "FAIL" : "ok",
+           get_access_kernel());
+    free(tags_opt);
+    free(tags_ref);
+    free(dirty_opt);
+    free(dirty_ref);
+    if (failures)
+      break;
+  }
+
+  free(t);
+  return failures ? 1 : 0;
+}
+/************************************************************/